@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "util_memory_pool.h"
+#include "util_memory_pool.hpp"
+
+/*
+ * memory_pool_bench [--thread N] [--op N] [--slot N] [--format json|csv] [--output path]
+ *
+ * every thread keeps "slot" live objects and replaces a random slot with a random type "op" times.
+ * (user/session/room-style mixed sizes, so freed blocks of one class are not always reused right away)
+ * each workload runs with 1 thread and N threads for memory_pool_c(lock, thread-cache, shared_ptr), new/delete and malloc.
+ */
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string BENCH_GRP_NAME = "BENCH";
+
+const std::uint32_t TYPE_CNT           = 3;
+const std::uint32_t LATENCY_SAMPLE_CNT = 16; // one of 16 ops is timed.
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+template <std::size_t Byte>
+class bench_node_c : public util::base_node_c
+{
+	public:
+		bench_node_c(const std::string& grp_name, std::uint64_t id)
+			: util::base_node_c(grp_name), _id(id) {}
+
+	public:
+		std::uint64_t _id;
+		char          _payload[Byte];
+};
+
+using user_node_c    = bench_node_c<72>;  // user_info-style
+using session_node_c = bench_node_c<104>; // session_info-style
+using room_node_c    = bench_node_c<40>;  // room_info-style
+
+/* same size without pool header, for new/delete and malloc. */
+template <typename Node>
+struct bench_plain_st
+{
+	std::uint64_t id;
+	char          payload[sizeof(Node) - sizeof(std::uint64_t)];
+};
+
+const std::size_t g_type_byte[TYPE_CNT] = {sizeof(user_node_c), sizeof(session_node_c), sizeof(room_node_c)};
+
+struct bench_option_st
+{
+	std::uint32_t thread_cnt = std::max(2u, std::thread::hardware_concurrency());
+	std::uint64_t op_cnt     = 1000000; // per thread
+	std::uint32_t slot_cnt   = 4096;    // live objects per thread
+	std::string   format     = "json";
+	std::string   output;
+};
+
+struct bench_result_st
+{
+	std::string   name;
+	std::uint32_t thread_cnt     = 0;
+	std::uint64_t op_cnt         = 0; // alloc/free pairs of every thread
+	double        elapsed_sec    = 0;
+	double        mops           = 0;
+	std::uint64_t p50_ns         = 0;
+	std::uint64_t p99_ns         = 0;
+	std::uint64_t p999_ns        = 0;
+	std::uint64_t max_ns         = 0;
+	std::uint64_t live_byte      = 0; // requested bytes of live objects at peak
+	std::uint64_t footprint_byte = 0; // bytes held by allocator at peak (0 if unknown)
+	double        fragmentation  = 0; // 1 - live / footprint
+};
+
+/* xorshift64, deterministic per thread. */
+struct bench_rng_st
+{
+	std::uint64_t state;
+
+	std::uint64_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+/* <-- allocators --> */
+struct mpool_alloc_st
+{
+	using handle_t = util::pool_unique_ptr<util::base_node_c>;
+
+	util::memory_pool_c mpool;
+
+	mpool_alloc_st(bool use_thread_cache) : mpool(BENCH_GRP_NAME, make_option(use_thread_cache)) {}
+
+	static util::mpool_option_st make_option(bool use_thread_cache)
+	{
+		util::mpool_option_st option;
+		option.use_page_cnt     = 1024;
+		option.growth           = util::MPOOL_GROWTH::LINEAR;
+		option.use_thread_cache = use_thread_cache;
+		return option;
+	}
+
+	handle_t alloc(std::uint32_t type, std::uint64_t id)
+	{
+		switch(type)
+		{
+			case 0: return mpool.alloc_unique<user_node_c>(BENCH_GRP_NAME, id);
+			case 1: return mpool.alloc_unique<session_node_c>(BENCH_GRP_NAME, id);
+			default: return mpool.alloc_unique<room_node_c>(BENCH_GRP_NAME, id);
+		}
+	}
+
+	void free(handle_t& handle) { handle.reset(); }
+	std::uint64_t get_footprint() { return mpool.get_cur_byte(); }
+};
+
+struct mpool_shared_alloc_st
+{
+	using handle_t = std::shared_ptr<util::base_node_c>;
+
+	util::memory_pool_c mpool;
+
+	mpool_shared_alloc_st() : mpool(BENCH_GRP_NAME, mpool_alloc_st::make_option(false)) {}
+
+	handle_t alloc(std::uint32_t type, std::uint64_t id)
+	{
+		switch(type)
+		{
+			case 0: return mpool.alloc<user_node_c>(BENCH_GRP_NAME, id);
+			case 1: return mpool.alloc<session_node_c>(BENCH_GRP_NAME, id);
+			default: return mpool.alloc<room_node_c>(BENCH_GRP_NAME, id);
+		}
+	}
+
+	void free(handle_t& handle) { handle.reset(); }
+	std::uint64_t get_footprint() { return mpool.get_cur_byte(); }
+};
+
+/* footprint of the system heap. (glibc only) */
+static std::uint64_t get_heap_byte()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+struct new_delete_alloc_st
+{
+	struct handle_t
+	{
+		void*         ptr  = nullptr;
+		std::uint32_t type = 0;
+	};
+
+	std::uint64_t base_byte = get_heap_byte();
+
+	handle_t alloc(std::uint32_t type, std::uint64_t id)
+	{
+		switch(type)
+		{
+			case 0: return handle_t{new bench_plain_st<user_node_c>{id, {}}, type};
+			case 1: return handle_t{new bench_plain_st<session_node_c>{id, {}}, type};
+			default: return handle_t{new bench_plain_st<room_node_c>{id, {}}, type};
+		}
+	}
+
+	void free(handle_t& handle)
+	{
+		switch(handle.type)
+		{
+			case 0: delete static_cast<bench_plain_st<user_node_c>*>(handle.ptr); break;
+			case 1: delete static_cast<bench_plain_st<session_node_c>*>(handle.ptr); break;
+			default: delete static_cast<bench_plain_st<room_node_c>*>(handle.ptr); break;
+		}
+
+		handle.ptr = nullptr;
+	}
+
+	std::uint64_t get_footprint() { std::uint64_t heap_byte = get_heap_byte(); return heap_byte > base_byte ? heap_byte - base_byte : 0; }
+};
+
+struct malloc_alloc_st
+{
+	using handle_t = void*;
+
+	std::uint64_t base_byte = get_heap_byte();
+
+	handle_t alloc(std::uint32_t type, std::uint64_t id)
+	{
+		void* ptr = std::malloc(g_type_byte[type]);
+		if(nullptr != ptr) {
+			*static_cast<std::uint64_t*>(ptr) = id;
+		}
+
+		return ptr;
+	}
+
+	void free(handle_t& handle)
+	{
+		std::free(handle);
+		handle = nullptr;
+	}
+
+	std::uint64_t get_footprint() { std::uint64_t heap_byte = get_heap_byte(); return heap_byte > base_byte ? heap_byte - base_byte : 0; }
+};
+
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+template <typename Alloc>
+static bench_result_st run_workload(const std::string& name, Alloc& allocator, const bench_option_st& option, std::uint32_t thread_cnt)
+{
+	using handle_t = typename Alloc::handle_t;
+	using clock_t  = std::chrono::steady_clock;
+
+	std::atomic<std::uint32_t> ready_cnt{0};
+	std::atomic<std::uint32_t> done_cnt{0};
+	std::atomic<bool>          is_start{false};
+	std::atomic<bool>          is_release{false};
+	std::atomic<std::uint64_t> live_byte{0};
+
+	std::vector<std::vector<std::uint64_t>> vec_latency(thread_cnt);
+	std::vector<std::thread> vec_thread;
+
+	for(std::uint32_t t = 0; t < thread_cnt; t++)
+	{
+		vec_thread.emplace_back([&, t]() {
+			bench_rng_st rng{0x9E3779B97F4A7C15ULL * (t + 1)};
+			std::vector<handle_t> vec_slot(option.slot_cnt);
+			std::vector<std::uint32_t> vec_type(option.slot_cnt);
+			std::uint64_t thread_byte = 0;
+
+			for(std::uint32_t idx = 0; idx < option.slot_cnt; idx++)
+			{
+				vec_type[idx] = rng.next() % TYPE_CNT;
+				vec_slot[idx] = allocator.alloc(vec_type[idx], idx);
+				thread_byte += g_type_byte[vec_type[idx]];
+			}
+
+			std::vector<std::uint64_t>& latency = vec_latency[t];
+			latency.reserve(option.op_cnt / LATENCY_SAMPLE_CNT + 1);
+
+			ready_cnt++;
+			while(false == is_start.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+
+			for(std::uint64_t op = 0; op < option.op_cnt; op++)
+			{
+				std::uint64_t random   = rng.next();
+				std::uint32_t idx      = random % option.slot_cnt;
+				std::uint32_t type     = (random >> 32) % TYPE_CNT;
+				bool          is_timed = 0 == op % LATENCY_SAMPLE_CNT;
+
+				clock_t::time_point begin_time;
+				if(true == is_timed) {
+					begin_time = clock_t::now();
+				}
+
+				allocator.free(vec_slot[idx]);
+				vec_slot[idx] = allocator.alloc(type, op);
+
+				if(true == is_timed) {
+					latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now() - begin_time).count());
+				}
+
+				thread_byte += g_type_byte[type];
+				thread_byte -= g_type_byte[vec_type[idx]];
+				vec_type[idx] = type;
+			}
+
+			// keep objects until every thread is done, so footprint is measured at peak.
+			live_byte += thread_byte;
+			done_cnt++;
+			while(false == is_release.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+
+			for(auto& slot : vec_slot) {
+				allocator.free(slot);
+			}
+		});
+	}
+
+	while(ready_cnt.load() < thread_cnt) {
+		std::this_thread::yield();
+	}
+
+	clock_t::time_point begin_time = clock_t::now();
+	is_start.store(true, std::memory_order_release);
+
+	while(done_cnt.load() < thread_cnt) {
+		std::this_thread::yield();
+	}
+
+	clock_t::time_point end_time = clock_t::now();
+
+	bench_result_st result;
+	result.name           = name;
+	result.thread_cnt     = thread_cnt;
+	result.op_cnt         = option.op_cnt * thread_cnt;
+	result.elapsed_sec    = std::chrono::duration<double>(end_time - begin_time).count();
+	result.mops           = result.op_cnt / result.elapsed_sec / 1000000.0;
+	result.live_byte      = live_byte.load();
+	result.footprint_byte = allocator.get_footprint();
+	result.fragmentation  = 0 == result.footprint_byte ? 0.0 : 1.0 - static_cast<double>(result.live_byte) / result.footprint_byte;
+
+	is_release.store(true, std::memory_order_release);
+	for(auto& th : vec_thread) {
+		th.join();
+	}
+
+	std::vector<std::uint64_t> vec_total;
+	for(auto& latency : vec_latency) {
+		vec_total.insert(vec_total.end(), latency.begin(), latency.end());
+	}
+
+	if(false == vec_total.empty())
+	{
+		std::sort(vec_total.begin(), vec_total.end());
+		auto percentile = [&vec_total](double ratio) { return vec_total[std::min<std::size_t>(vec_total.size() - 1, vec_total.size() * ratio)]; };
+
+		result.p50_ns  = percentile(0.5);
+		result.p99_ns  = percentile(0.99);
+		result.p999_ns = percentile(0.999);
+		result.max_ns  = vec_total.back();
+	}
+
+	return result;
+}
+
+static std::string to_json(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "[\n";
+	for(std::size_t idx = 0; idx < vec_result.size(); idx++)
+	{
+		const bench_result_st& result = vec_result[idx];
+		out << "  {\"name\":\"" << result.name << "\",\"thread_cnt\":" << result.thread_cnt << ",\"op_cnt\":" << result.op_cnt
+			<< ",\"elapsed_sec\":" << result.elapsed_sec << ",\"mops\":" << result.mops
+			<< ",\"p50_ns\":" << result.p50_ns << ",\"p99_ns\":" << result.p99_ns << ",\"p999_ns\":" << result.p999_ns << ",\"max_ns\":" << result.max_ns
+			<< ",\"live_byte\":" << result.live_byte << ",\"footprint_byte\":" << result.footprint_byte << ",\"fragmentation\":" << result.fragmentation << "}"
+			<< (idx + 1 < vec_result.size() ? ",\n" : "\n");
+	}
+
+	out << "]\n";
+	return out.str();
+}
+
+static std::string to_csv(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "name,thread_cnt,op_cnt,elapsed_sec,mops,p50_ns,p99_ns,p999_ns,max_ns,live_byte,footprint_byte,fragmentation\n";
+	for(const auto& result : vec_result)
+	{
+		out << result.name << ',' << result.thread_cnt << ',' << result.op_cnt << ',' << result.elapsed_sec << ',' << result.mops << ','
+			<< result.p50_ns << ',' << result.p99_ns << ',' << result.p999_ns << ',' << result.max_ns << ','
+			<< result.live_byte << ',' << result.footprint_byte << ',' << result.fragmentation << '\n';
+	}
+
+	return out.str();
+}
+
+static bool parse_option(int argc, char** argv, bench_option_st& option)
+{
+	for(int idx = 1; idx < argc; idx++)
+	{
+		std::string key = argv[idx];
+		if(idx + 1 >= argc)
+		{
+			std::cerr << "missing value of " << key << '\n';
+			return false;
+		}
+
+		std::string value = argv[++idx];
+		if("--thread" == key) {
+			option.thread_cnt = std::max(1, std::atoi(value.c_str()));
+		}
+		else if("--op" == key) {
+			option.op_cnt = std::strtoull(value.c_str(), nullptr, 10);
+		}
+		else if("--slot" == key) {
+			option.slot_cnt = std::max(1, std::atoi(value.c_str()));
+		}
+		else if("--format" == key && ("json" == value || "csv" == value)) {
+			option.format = value;
+		}
+		else if("--output" == key) {
+			option.output = value;
+		}
+		else
+		{
+			std::cerr << "unknown option " << key << ' ' << value << '\n';
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bench_option_st option;
+	if(false == parse_option(argc, argv, option))
+	{
+		std::cerr << "usage: memory_pool_bench [--thread N] [--op N] [--slot N] [--format json|csv] [--output path]\n";
+		return 1;
+	}
+
+	std::vector<std::uint32_t> vec_thread_cnt = {1};
+	if(1 < option.thread_cnt) {
+		vec_thread_cnt.push_back(option.thread_cnt);
+	}
+
+	std::vector<bench_result_st> vec_result;
+	for(std::uint32_t thread_cnt : vec_thread_cnt)
+	{
+		{
+			mpool_alloc_st allocator(false);
+			vec_result.push_back(run_workload("memory_pool", allocator, option, thread_cnt));
+		}
+		{
+			mpool_alloc_st allocator(true);
+			vec_result.push_back(run_workload("memory_pool_tcache", allocator, option, thread_cnt));
+		}
+		{
+			mpool_shared_alloc_st allocator;
+			vec_result.push_back(run_workload("memory_pool_shared_ptr", allocator, option, thread_cnt));
+		}
+		{
+			new_delete_alloc_st allocator;
+			vec_result.push_back(run_workload("new_delete", allocator, option, thread_cnt));
+		}
+		{
+			malloc_alloc_st allocator;
+			vec_result.push_back(run_workload("malloc", allocator, option, thread_cnt));
+		}
+	}
+
+	std::string report = "csv" == option.format ? to_csv(vec_result) : to_json(vec_result);
+	if(true == option.output.empty()) {
+		std::cout << report;
+	}
+	else
+	{
+		std::ofstream file(option.output);
+		if(false == file.is_open())
+		{
+			std::cerr << "can't open " << option.output << '\n';
+			return 1;
+		}
+
+		file << report;
+	}
+
+	return 0;
+}
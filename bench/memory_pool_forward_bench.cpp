@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util_memory_pool.h"
+#include "util_memory_pool.hpp"
+
+/*
+ * memory_pool_forward_bench [--op N] [--format json|csv]
+ *
+ * cost of constructor arguments for a string-heavy node. heap allocations are counted by global operator new.
+ * legacy_by_value  : old alloc path. (every layer takes Args by value and passes lvalues, so each string is copied three times)
+ * forward_lvalue   : alloc with lvalue arguments, one copy into the node.
+ * forward_move     : alloc with temporaries, moved into the node without any copy.
+ * emplace_move     : emplace with temporaries. (group-name of the pool)
+ */
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string BENCH_GRP_NAME = "BENCH";
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+class profile_node_c : public util::base_node_c
+{
+	public:
+		profile_node_c(const std::string& grp_name, std::string name, std::string country, std::string address)
+			: util::base_node_c(grp_name), _name(std::move(name)), _country(std::move(country)), _address(std::move(address)) {}
+
+	public:
+		std::string _name;
+		std::string _country;
+		std::string _address;
+};
+
+struct bench_option_st
+{
+	std::uint64_t op_cnt = 1000000;
+	std::string   format = "json";
+};
+
+struct bench_result_st
+{
+	std::string name;
+	double      ns_per_op         = 0.0;
+	double      heap_alloc_per_op = 0.0;
+};
+
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+static std::atomic<std::uint64_t> g_heap_alloc_cnt{0};
+
+static void* counted_alloc(std::size_t byte, std::size_t align_byte)
+{
+	g_heap_alloc_cnt.fetch_add(1, std::memory_order_relaxed);
+
+	byte      = 0 == byte ? 1 : byte;
+	void* ptr = alignof(std::max_align_t) < align_byte ? std::aligned_alloc(align_byte, (byte + align_byte - 1) / align_byte * align_byte) : std::malloc(byte);
+	if(nullptr != ptr) {
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+// every replaceable form is replaced, so new and delete always pair malloc with free.
+void* operator new(std::size_t byte) { return counted_alloc(byte, alignof(std::max_align_t)); }
+void* operator new[](std::size_t byte) { return counted_alloc(byte, alignof(std::max_align_t)); }
+void* operator new(std::size_t byte, std::align_val_t align_byte) { return counted_alloc(byte, static_cast<std::size_t>(align_byte)); }
+void* operator new[](std::size_t byte, std::align_val_t align_byte) { return counted_alloc(byte, static_cast<std::size_t>(align_byte)); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+/* same shape as alloc() before perfect-forwarding. */
+template <typename U, typename... Args>
+static U* legacy_construct(void* block, const std::string& grp_name, Args... args)
+{
+	return new(block) U(grp_name, args...);
+}
+
+template <typename U, typename... Args>
+static U* legacy_alloc(util::memory_pool_c& mpool, const std::string& grp_name, Args... args)
+{
+	void* block = mpool.alloc_byte(sizeof(U), alignof(U));
+	return nullptr == block ? nullptr : legacy_construct<U>(block, grp_name, args...);
+}
+
+template <typename Func>
+static bench_result_st run_workload(const std::string& name, std::uint64_t op_cnt, Func&& func)
+{
+	std::uint64_t begin_alloc_cnt = g_heap_alloc_cnt.load(std::memory_order_relaxed);
+	auto begin_time               = std::chrono::steady_clock::now();
+
+	for(std::uint64_t op = 0; op < op_cnt; op++) {
+		func(op);
+	}
+
+	auto elapsed_ns             = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_time).count();
+	std::uint64_t heap_alloc_cnt = g_heap_alloc_cnt.load(std::memory_order_relaxed) - begin_alloc_cnt;
+
+	bench_result_st result;
+	result.name              = name;
+	result.ns_per_op         = static_cast<double>(elapsed_ns) / op_cnt;
+	result.heap_alloc_per_op = static_cast<double>(heap_alloc_cnt) / op_cnt;
+	return result;
+}
+
+static std::string to_json(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "[\n";
+	for(std::size_t idx = 0; idx < vec_result.size(); idx++)
+	{
+		const bench_result_st& result = vec_result[idx];
+		out << "  {\"name\": \"" << result.name << "\", \"ns_per_op\": " << result.ns_per_op << ", \"heap_alloc_per_op\": " << result.heap_alloc_per_op << "}"
+			<< (idx + 1 < vec_result.size() ? ",\n" : "\n");
+	}
+
+	out << "]\n";
+	return out.str();
+}
+
+static std::string to_csv(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "name,ns_per_op,heap_alloc_per_op\n";
+	for(const auto& result : vec_result) {
+		out << result.name << ',' << result.ns_per_op << ',' << result.heap_alloc_per_op << '\n';
+	}
+
+	return out.str();
+}
+
+static bool parse_option(int argc, char** argv, bench_option_st& option)
+{
+	for(int idx = 1; idx < argc; idx++)
+	{
+		std::string key = argv[idx];
+		if(idx + 1 >= argc)
+		{
+			std::cerr << "missing value of " << key << '\n';
+			return false;
+		}
+
+		std::string value = argv[++idx];
+		if("--op" == key) {
+			option.op_cnt = std::max<std::uint64_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+		}
+		else if("--format" == key && ("json" == value || "csv" == value)) {
+			option.format = value;
+		}
+		else
+		{
+			std::cerr << "unknown option " << key << ' ' << value << '\n';
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bench_option_st option;
+	if(false == parse_option(argc, argv, option))
+	{
+		std::cerr << "usage: memory_pool_forward_bench [--op N] [--format json|csv]\n";
+		return 1;
+	}
+
+	// longer than small-string buffer, so every copy is a heap allocation.
+	const std::string name(48, 'n');
+	const std::string country(40, 'c');
+	const std::string address(96, 'a');
+
+	util::memory_pool_c mpool(BENCH_GRP_NAME, 16);
+
+	std::vector<bench_result_st> vec_result;
+	vec_result.push_back(run_workload("legacy_by_value", option.op_cnt, [&](std::uint64_t) {
+		profile_node_c* node = legacy_alloc<profile_node_c>(mpool, BENCH_GRP_NAME, name, country, address);
+		node->~profile_node_c();
+		mpool.release_byte(node, sizeof(profile_node_c), alignof(profile_node_c));
+	}));
+
+	vec_result.push_back(run_workload("forward_lvalue", option.op_cnt, [&](std::uint64_t) {
+		util::pool_unique_ptr<profile_node_c> node = mpool.alloc_unique<profile_node_c>(BENCH_GRP_NAME, name, country, address);
+	}));
+
+	// temporaries are built in every workload below. (three allocations per op are the strings themselves)
+	vec_result.push_back(run_workload("forward_move", option.op_cnt, [&](std::uint64_t) {
+		std::string temp_name(name), temp_country(country), temp_address(address);
+		util::pool_unique_ptr<profile_node_c> node = mpool.alloc_unique<profile_node_c>(BENCH_GRP_NAME, std::move(temp_name), std::move(temp_country), std::move(temp_address));
+	}));
+
+	vec_result.push_back(run_workload("emplace_move", option.op_cnt, [&](std::uint64_t) {
+		std::string temp_name(name), temp_country(country), temp_address(address);
+		util::pool_unique_ptr<profile_node_c> node = mpool.emplace<profile_node_c>(std::move(temp_name), std::move(temp_country), std::move(temp_address));
+	}));
+
+	std::cout << ("csv" == option.format ? to_csv(vec_result) : to_json(vec_result));
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util_thread_pool.h"
+
+/*
+ * thread_pool_bench [--depth N] [--work N] [--max-thread N] [--format json|csv]
+ *
+ * fine-grained fork-join. one root task splits itself into two tasks until depth, and each leaf spins work iterations.
+ * every task except the root is dispatched inside a consumer, so it is pushed to the own deque and balanced by stealing.
+ * same workload runs with 1, 2, 4 ... max-thread consumers, and speedup is against 1 consumer.
+ */
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string BENCH_POOL_NAME = "BENCH";
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+struct bench_option_st
+{
+	std::uint32_t depth      = 16;
+	std::uint32_t work       = 2000;
+	std::uint32_t max_thread = std::max<std::uint32_t>(1, std::thread::hardware_concurrency());
+	std::string   format     = "json";
+};
+
+struct bench_result_st
+{
+	std::uint32_t thread_cnt   = 0;
+	std::uint64_t task_cnt     = 0;
+	double        elapsed_ms   = 0.0;
+	double        ns_per_task  = 0.0;
+	double        speedup      = 0.0;
+	std::uint64_t steal_cnt    = 0;
+};
+
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+static bench_result_st run_fork_join(std::uint32_t thread_cnt, const bench_option_st& option)
+{
+	util::thread_pool_c thread_pool;
+	thread_pool.create_pool(BENCH_POOL_NAME, static_cast<std::uint16_t>(thread_cnt));
+
+	std::uint64_t              leaf_total = 1ull << option.depth;
+	std::atomic<std::uint64_t> leaf_cnt{0};
+
+	std::function<void(std::uint32_t)> fork_join = [&](std::uint32_t depth)
+	{
+		if(option.depth == depth)
+		{
+			volatile std::uint64_t sum = 0;
+			for(std::uint32_t i = 0; i < option.work; i++) {
+				sum = sum + i;
+			}
+
+			leaf_cnt.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		thread_pool.async_dispatch(fork_join, depth + 1);
+		thread_pool.async_dispatch(fork_join, depth + 1);
+	};
+
+	auto begin_time = std::chrono::steady_clock::now();
+
+	thread_pool.async_dispatch(fork_join, 0u);
+	while(leaf_cnt.load(std::memory_order_relaxed) < leaf_total) {
+		std::this_thread::yield();
+	}
+
+	auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_time).count();
+
+	bench_result_st result;
+	result.thread_cnt  = thread_cnt;
+	result.task_cnt    = leaf_total * 2 - 1;
+	result.elapsed_ms  = static_cast<double>(elapsed_ns) / 1000000.0;
+	result.ns_per_task = static_cast<double>(elapsed_ns) / result.task_cnt;
+	result.steal_cnt   = thread_pool.get_steal_cnt();
+	return result;
+}
+
+static std::string to_json(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "[\n";
+	for(std::size_t idx = 0; idx < vec_result.size(); idx++)
+	{
+		const bench_result_st& result = vec_result[idx];
+		out << "  {\"thread_cnt\": " << result.thread_cnt << ", \"task_cnt\": " << result.task_cnt << ", \"elapsed_ms\": " << result.elapsed_ms
+			<< ", \"ns_per_task\": " << result.ns_per_task << ", \"speedup\": " << result.speedup << ", \"steal_cnt\": " << result.steal_cnt << "}"
+			<< (idx + 1 < vec_result.size() ? ",\n" : "\n");
+	}
+
+	out << "]\n";
+	return out.str();
+}
+
+static std::string to_csv(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "thread_cnt,task_cnt,elapsed_ms,ns_per_task,speedup,steal_cnt\n";
+	for(const auto& result : vec_result) {
+		out << result.thread_cnt << ',' << result.task_cnt << ',' << result.elapsed_ms << ',' << result.ns_per_task << ',' << result.speedup << ',' << result.steal_cnt << '\n';
+	}
+
+	return out.str();
+}
+
+static bool parse_option(int argc, char** argv, bench_option_st& option)
+{
+	for(int idx = 1; idx < argc; idx++)
+	{
+		std::string key = argv[idx];
+		if(idx + 1 >= argc)
+		{
+			std::cerr << "missing value of " << key << '\n';
+			return false;
+		}
+
+		std::string value = argv[++idx];
+		if("--depth" == key) {
+			option.depth = std::clamp<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10), 1, 24);
+		}
+		else if("--work" == key) {
+			option.work = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+		}
+		else if("--max-thread" == key) {
+			option.max_thread = std::clamp<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10), 1, 256);
+		}
+		else if("--format" == key && ("json" == value || "csv" == value)) {
+			option.format = value;
+		}
+		else
+		{
+			std::cerr << "unknown option " << key << ' ' << value << '\n';
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bench_option_st option;
+	if(false == parse_option(argc, argv, option))
+	{
+		std::cerr << "usage: thread_pool_bench [--depth N] [--work N] [--max-thread N] [--format json|csv]\n";
+		return 1;
+	}
+
+	std::vector<std::uint32_t> vec_thread_cnt;
+	for(std::uint32_t thread_cnt = 1; thread_cnt < option.max_thread; thread_cnt *= 2) {
+		vec_thread_cnt.push_back(thread_cnt);
+	}
+
+	vec_thread_cnt.push_back(option.max_thread);
+
+	std::vector<bench_result_st> vec_result;
+	for(std::uint32_t thread_cnt : vec_thread_cnt) {
+		vec_result.push_back(run_fork_join(thread_cnt, option));
+	}
+
+	for(auto& result : vec_result) {
+		result.speedup = vec_result.front().elapsed_ms / result.elapsed_ms;
+	}
+
+	std::cout << ("csv" == option.format ? to_csv(vec_result) : to_json(vec_result));
+	return 0;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util_thread_pool.h"
+
+/*
+ * thread_pool_latency_bench [--task N] [--burst N] [--interval-us N] [--thread N] [--format json|csv]
+ *
+ * submit-to-start latency of a tiny task. (time from the async_dispatch() call to the first line of the task)
+ * one thread outside the pool submits burst tasks at once, and rests interval-us so the consumers park between bursts.
+ * producer : TPOOL_DISPATCH::PRODUCER. event_fd -> producer thread -> consumer.
+ * direct   : TPOOL_DISPATCH::DIRECT. submitter wakes a parked consumer by itself.
+ */
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string BENCH_POOL_NAME = "BENCH";
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+struct bench_option_st
+{
+	std::uint32_t task_cnt    = 1000;
+	std::uint32_t burst       = 1;
+	std::uint32_t interval_us = 200;
+	std::uint32_t thread_cnt  = 4;
+	std::string   format      = "json";
+};
+
+struct bench_result_st
+{
+	std::string name;
+	double      mean_us = 0.0;
+	double      p50_us  = 0.0;
+	double      p99_us  = 0.0;
+	double      max_us  = 0.0;
+};
+
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+static bench_result_st run_latency(const std::string& name, util::TPOOL_DISPATCH dispatch_mode, const bench_option_st& option)
+{
+	util::thread_pool_c thread_pool;
+	thread_pool.create_pool(BENCH_POOL_NAME, static_cast<std::uint16_t>(option.thread_cnt), dispatch_mode);
+
+	// each task writes only its own slot.
+	std::vector<std::int64_t>  vec_latency_ns(option.task_cnt, 0);
+	std::atomic<std::uint32_t> done_cnt{0};
+
+	for(std::uint32_t idx = 0; idx < option.task_cnt;)
+	{
+		for(std::uint32_t burst = 0; burst < option.burst && idx < option.task_cnt; burst++, idx++)
+		{
+			auto submit_time = std::chrono::steady_clock::now();
+			thread_pool.async_dispatch([&vec_latency_ns, &done_cnt, submit_time](std::uint32_t slot) {
+				vec_latency_ns[slot] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - submit_time).count();
+				done_cnt.fetch_add(1, std::memory_order_release);
+			}, idx);
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(option.interval_us));
+	}
+
+	while(done_cnt.load(std::memory_order_acquire) < option.task_cnt) {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+
+	std::sort(vec_latency_ns.begin(), vec_latency_ns.end());
+
+	std::int64_t total_ns = 0;
+	for(std::int64_t latency_ns : vec_latency_ns) {
+		total_ns += latency_ns;
+	}
+
+	auto to_us = [](std::int64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+	bench_result_st result;
+	result.name    = name;
+	result.mean_us = to_us(total_ns) / option.task_cnt;
+	result.p50_us  = to_us(vec_latency_ns[vec_latency_ns.size() / 2]);
+	result.p99_us  = to_us(vec_latency_ns[std::min<std::size_t>(vec_latency_ns.size() - 1, vec_latency_ns.size() * 99 / 100)]);
+	result.max_us  = to_us(vec_latency_ns.back());
+	return result;
+}
+
+static std::string to_json(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "[\n";
+	for(std::size_t idx = 0; idx < vec_result.size(); idx++)
+	{
+		const bench_result_st& result = vec_result[idx];
+		out << "  {\"name\": \"" << result.name << "\", \"mean_us\": " << result.mean_us << ", \"p50_us\": " << result.p50_us << ", \"p99_us\": " << result.p99_us
+			<< ", \"max_us\": " << result.max_us << "}" << (idx + 1 < vec_result.size() ? ",\n" : "\n");
+	}
+
+	out << "]\n";
+	return out.str();
+}
+
+static std::string to_csv(const std::vector<bench_result_st>& vec_result)
+{
+	std::ostringstream out;
+	out << "name,mean_us,p50_us,p99_us,max_us\n";
+	for(const auto& result : vec_result) {
+		out << result.name << ',' << result.mean_us << ',' << result.p50_us << ',' << result.p99_us << ',' << result.max_us << '\n';
+	}
+
+	return out.str();
+}
+
+static bool parse_option(int argc, char** argv, bench_option_st& option)
+{
+	for(int idx = 1; idx < argc; idx++)
+	{
+		std::string key = argv[idx];
+		if(idx + 1 >= argc)
+		{
+			std::cerr << "missing value of " << key << '\n';
+			return false;
+		}
+
+		std::string value = argv[++idx];
+		if("--task" == key) {
+			option.task_cnt = std::max<std::uint32_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+		}
+		else if("--burst" == key) {
+			option.burst = std::max<std::uint32_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+		}
+		else if("--interval-us" == key) {
+			option.interval_us = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+		}
+		else if("--thread" == key) {
+			option.thread_cnt = std::clamp<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10), 1, 256);
+		}
+		else if("--format" == key && ("json" == value || "csv" == value)) {
+			option.format = value;
+		}
+		else
+		{
+			std::cerr << "unknown option " << key << ' ' << value << '\n';
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bench_option_st option;
+	if(false == parse_option(argc, argv, option))
+	{
+		std::cerr << "usage: thread_pool_latency_bench [--task N] [--burst N] [--interval-us N] [--thread N] [--format json|csv]\n";
+		return 1;
+	}
+
+	std::vector<bench_result_st> vec_result;
+	vec_result.push_back(run_latency("producer", util::TPOOL_DISPATCH::PRODUCER, option));
+	vec_result.push_back(run_latency("direct", util::TPOOL_DISPATCH::DIRECT, option));
+
+	std::cout << ("csv" == option.format ? to_csv(vec_result) : to_json(vec_result));
+	return 0;
+}
@@ -0,0 +1,149 @@
+#ifndef BUFFER_POOL_GTEST_CPP
+#define BUFFER_POOL_GTEST_CPP
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util_buffer_pool.h"
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string BUFFER_GRP_NAME = "BUFFER";
+
+/* ====================================================================== */
+/* =============================== GTEST ================================ */
+/* ====================================================================== */
+TEST(BufferPoolTest, SizeClassAndReuse)
+{
+	/*
+	 * capacity is rounded up to power-of-two, and a released buffer is reused by the next request of its class.
+	 * released buffers are cached in the buffer pool until shrink(). requests over BPOOL_MAX_BYTE are refused.
+	 */
+	util::memory_pool_c mpool(BUFFER_GRP_NAME, 64);
+	util::buffer_pool_c bpool(mpool);
+
+	EXPECT_EQ(util::buffer_pool_c::get_class_idx(1), 0);
+	EXPECT_EQ(util::buffer_pool_c::get_class_idx(64), 0);
+	EXPECT_EQ(util::buffer_pool_c::get_class_idx(65), 1);
+	EXPECT_EQ(util::buffer_pool_c::get_class_idx(util::BPOOL_MAX_BYTE), util::BPOOL_CLASS_CNT - 1);
+
+	std::uint8_t* prev_data = nullptr;
+	{
+		util::byte_buffer_c buffer = bpool.alloc(1000);
+		ASSERT_TRUE(buffer);
+		EXPECT_EQ(buffer.size(), 1000);
+		EXPECT_EQ(buffer.capacity(), 1024);
+		EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.data()) % alignof(std::max_align_t), 0);
+		EXPECT_EQ(bpool.get_live_cnt(), 1);
+
+		prev_data = buffer.data();
+	}
+
+	EXPECT_EQ(bpool.get_live_cnt(), 0);
+	EXPECT_EQ(bpool.get_cached_cnt(), 1);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 1);
+
+	util::byte_buffer_c buffer = bpool.alloc(513);
+	EXPECT_EQ(buffer.data(), prev_data);
+	EXPECT_EQ(bpool.get_cached_cnt(), 0);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 1);
+	EXPECT_EQ(bpool.get_class_alloc_cnt(util::buffer_pool_c::get_class_idx(1024)), 2);
+
+	// big classes are cached too. (never searched in the large free-list of memory_pool_c)
+	std::uint8_t* big_data = bpool.alloc(util::BPOOL_MAX_BYTE).data();
+	EXPECT_EQ(bpool.alloc(util::BPOOL_MAX_BYTE - 1).data(), big_data);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 2);
+
+	buffer.reset();
+	EXPECT_EQ(bpool.shrink(), 2);
+	EXPECT_EQ(bpool.get_cached_cnt(), 0);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	EXPECT_FALSE(bpool.alloc(util::BPOOL_MAX_BYTE + 1));
+}
+
+TEST(BufferPoolTest, ZeroCopySlice)
+{
+	/*
+	 * slices share the storage of the receive buffer, and the storage is recycled after the last view is gone.
+	 */
+	util::memory_pool_c mpool(BUFFER_GRP_NAME, 64);
+	util::buffer_pool_c bpool(mpool);
+
+	const char packet[] = "HEADbody-of-message";
+
+	util::byte_buffer_c header;
+	util::byte_buffer_c body;
+	{
+		util::byte_buffer_c recv_buffer = bpool.alloc(util::BPOOL_MIN_BYTE);
+		std::memcpy(recv_buffer.data(), packet, sizeof(packet) - 1);
+		ASSERT_TRUE(recv_buffer.resize(sizeof(packet) - 1));
+
+		header = recv_buffer.slice(0, 4);
+		body   = recv_buffer.slice(4, 100); // clamped.
+
+		EXPECT_EQ(recv_buffer.use_count(), 3);
+		EXPECT_TRUE(body.is_shared_with(recv_buffer));
+		EXPECT_EQ(body.data(), recv_buffer.data() + 4);
+		EXPECT_FALSE(recv_buffer.resize(util::BPOOL_MIN_BYTE + 1));
+	}
+
+	EXPECT_EQ(std::string(reinterpret_cast<char*>(header.data()), header.size()), "HEAD");
+	EXPECT_EQ(std::string(reinterpret_cast<char*>(body.data()), body.size()), "body-of-message");
+	EXPECT_EQ(body.use_count(), 2);
+	EXPECT_EQ(bpool.get_live_cnt(), 1);
+
+	// slice of slice.
+	util::byte_buffer_c word = body.slice(8, 7);
+	EXPECT_EQ(std::string(reinterpret_cast<char*>(word.data()), word.size()), "message");
+
+	util::byte_buffer_c moved = std::move(header);
+	EXPECT_FALSE(header);
+	EXPECT_EQ(moved.use_count(), 3);
+
+	moved.reset();
+	body.reset();
+	word.reset();
+	EXPECT_EQ(bpool.get_live_cnt(), 0);
+	EXPECT_EQ(mpool.get_alloc_cnt(), bpool.get_cached_cnt());
+
+	// views released on other threads.
+	std::vector<util::byte_buffer_c> vec_buffer;
+	for(int i = 0; i < 100; i++) {
+		vec_buffer.push_back(bpool.alloc(static_cast<std::size_t>(i) * 10));
+	}
+
+	std::vector<std::thread> vec_thread;
+	for(int t = 0; t < 4; t++)
+	{
+		std::vector<util::byte_buffer_c> vec_view;
+		for(auto& buffer : vec_buffer) {
+			vec_view.push_back(buffer.slice(0, 1));
+		}
+
+		vec_thread.emplace_back([vec_view = std::move(vec_view)]() mutable { vec_view.clear(); });
+	}
+
+	vec_buffer.clear();
+	for(auto& th : vec_thread) {
+		th.join();
+	}
+
+	EXPECT_EQ(bpool.get_live_cnt(), 0);
+	EXPECT_EQ(mpool.get_alloc_cnt(), bpool.get_cached_cnt());
+
+	bpool.shrink();
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+#endif
@@ -3,11 +3,17 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <map>
 #include <memory>
 #include <random>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include "util_memory_pool.h"
 #include "util_memory_pool.hpp"
+#include "util_memory_resource.h"
 
 /* ====================================================================== */
 /* ========================== DEFINE & ENUM ============================= */
@@ -99,6 +105,105 @@ class room_info : public util::base_node_c
 		std::string _host;
 };
 
+class packet_info : public util::base_node_c
+{
+	public:
+		packet_info(const std::string& grp_name, int seq)
+			: util::base_node_c(grp_name), _seq(seq) {}
+
+	public:
+		int _seq;
+		char _payload[2048]; // bigger than every size-class
+};
+
+class alignas(64) counter_info : public util::base_node_c
+{
+	public:
+		counter_info(const std::string& grp_name, std::uint64_t count)
+			: util::base_node_c(grp_name), _count(count) {}
+
+	public:
+		std::uint64_t _count;
+};
+
+class tick_info : public util::base_node_c
+{
+	public:
+		tick_info(const std::string& grp_name, std::uint64_t begin, std::uint64_t end)
+			: util::base_node_c(grp_name), _begin(begin), _end(end) {}
+
+	public:
+		std::uint64_t _begin;
+		std::uint64_t _end;
+};
+
+class profile_info : public util::recycle_node_c<profile_info>
+{
+	public:
+		profile_info(const std::string& grp_name, const std::string& name, const std::string& address)
+			: util::recycle_node_c<profile_info>(grp_name), _name(name), _address(address) { construct_cnt++; }
+
+		~profile_info() { destruct_cnt++; }
+
+		void assign(const std::string& name, const std::string& address)
+		{
+			_name    = name;
+			_address = address;
+		}
+
+		void reset()
+		{
+			_name.clear();
+			_address.clear();
+			reset_cnt++;
+		}
+
+	public:
+		std::string _name;
+		std::string _address;
+
+		static inline int construct_cnt = 0;
+		static inline int destruct_cnt  = 0;
+		static inline int reset_cnt     = 0;
+};
+
+class vip_profile_info : public profile_info
+{
+	public:
+		vip_profile_info(const std::string& grp_name, const std::string& name, const std::string& address, std::uint32_t grade)
+			: profile_info(grp_name, name, address), _grade(grade) {}
+
+	public:
+		std::uint32_t _grade;
+};
+
+class token_info : public util::base_node_c
+{
+	public:
+		token_info(const std::string& grp_name, std::unique_ptr<int> key, std::string name)
+			: util::base_node_c(grp_name), _key(std::move(key)), _name(std::move(name))
+		{
+			if(nullptr == _key) {
+				throw std::invalid_argument("key is empty");
+			}
+		}
+
+	public:
+		std::unique_ptr<int> _key;
+		std::string          _name;
+};
+
+class chat_info : public util::base_node_c
+{
+	public:
+		chat_info(const std::string& grp_name, std::pmr::memory_resource* resource)
+			: util::base_node_c(grp_name), _message(resource), _vec_receiver(resource) {}
+
+	public:
+		std::pmr::string                _message;
+		std::pmr::vector<std::uint64_t> _vec_receiver;
+};
+
 /* ====================================================================== */
 /* ========================== GLOBAL & STATIC =========================== */
 /* ====================================================================== */
@@ -262,7 +367,7 @@ TEST(MemoryPoolTest, MaxAlloc)
 		vec_user_info.push_back(user);
 	}
 
-	while(mpool.get_cur_byte() + smaller < mpool_max_byte)
+	while(mpool.get_cur_byte() + smaller <= mpool_max_byte)
 	{
 		std::shared_ptr<room_info> room = mpool.alloc<room_info>(USER_GRP_NAME, g_rinfo_1.id, g_rinfo_1.r_name, g_rinfo_1.host);
 		EXPECT_NE(room, nullptr);
@@ -285,16 +390,939 @@ TEST(MemoryPoolTest, DifferentGroupName)
 {
 	/*
 	 * if the group name between memory-pool object and argument used in "alloc()" mismatch, the return value created by "alloc()" will be nullptr. 
+	 * group-name is checked only with MPOOL_DEBUG_GRP_NAME, otherwise a node keeps only its owner pool.
 	 */
 	util::memory_pool_c mpool(USER_GRP_NAME);
 
 	std::shared_ptr<user_info> user = mpool.alloc<user_info>(ROOM_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender, g_uinfo_1.country, g_uinfo_1.address);
 	std::shared_ptr<session_info> sess = mpool.alloc<session_info>(USER_GRP_NAME, g_sinfo_1.id, g_sinfo_1.s_name, g_sinfo_1.u_name, g_sinfo_1.role);
 
+#ifdef MPOOL_DEBUG_GRP_NAME
 	EXPECT_EQ(user, nullptr);
+#else
+	EXPECT_NE(user, nullptr);
+	static_assert(sizeof(util::base_node_c) == 3 * sizeof(void*), "node header must be vptr + ref_cnt/block_size + owner");
+#endif
 	EXPECT_NE(sess, nullptr);	
 }
 
+TEST(MemoryPoolTest, SizeClassFreeList)
+{
+	/*
+	 * Freed node is kept in intrusive free-list of its size-class (or large free-list), and the next "alloc()" of the same block size pops it.
+	 * The reused address must be the last freed one and "get_pool_size()" must count nodes of every list.
+	 */
+	util::memory_pool_c mpool(USER_GRP_NAME, 4);
+
+	void* sess_addr   = nullptr;
+	void* packet_addr = nullptr;
+	{
+		std::shared_ptr<session_info> sess = mpool.alloc<session_info>(USER_GRP_NAME, g_sinfo_1.id, g_sinfo_1.s_name, g_sinfo_1.u_name, g_sinfo_1.role);
+		std::shared_ptr<packet_info> packet = mpool.alloc<packet_info>(USER_GRP_NAME, 1);
+		ASSERT_NE(sess, nullptr);
+		ASSERT_NE(packet, nullptr);
+
+		sess_addr   = sess.get();
+		packet_addr = packet.get();
+	}
+
+	EXPECT_EQ(mpool.get_pool_size(), 2);
+
+	uint64_t cur_byte = mpool.get_cur_byte();
+	{
+		std::shared_ptr<packet_info> packet = mpool.alloc<packet_info>(USER_GRP_NAME, 2);
+		std::shared_ptr<user_info> user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+		ASSERT_NE(packet, nullptr);
+		ASSERT_NE(user, nullptr);
+
+		EXPECT_EQ(packet.get(), packet_addr);
+		EXPECT_EQ(packet->_seq, 2);
+
+		if(sizeof(user_info) == sizeof(session_info)) {
+			EXPECT_EQ(static_cast<void*>(user.get()), sess_addr);
+		}
+
+		EXPECT_EQ(mpool.get_cur_byte(), sizeof(user_info) == sizeof(session_info) ? cur_byte : cur_byte + sizeof(user_info));
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+}
+
+TEST(MemoryPoolTest, IntrusivePoolPtr)
+{
+	/*
+	 * pool_ptr keeps reference count in base_node_c, and pool_unique_ptr has no reference count.
+	 * When the last handle is released, the node must return to the pool. (also through handle of base class)
+	 */
+	util::memory_pool_c mpool(USER_GRP_NAME);
+	{
+		util::pool_ptr<user_info> user_1 = mpool.alloc_ptr<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+		ASSERT_TRUE(user_1);
+		EXPECT_EQ(user_1.use_count(), 1);
+		EXPECT_EQ(user_1->_user_name, g_uinfo_1.u_name);
+
+		util::pool_ptr<user_info> user_2 = user_1;
+		EXPECT_EQ(user_1.use_count(), 2);
+		EXPECT_EQ(user_1.get(), user_2.get());
+
+		util::pool_ptr<util::base_node_c> base = std::move(user_2);
+		EXPECT_FALSE(user_2);
+		EXPECT_EQ(user_1.use_count(), 2);
+
+		user_1.reset();
+		EXPECT_EQ(base.use_count(), 1);
+		EXPECT_EQ(mpool.get_alloc_cnt(), 1);
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+	EXPECT_EQ(mpool.get_pool_size(), 1);
+
+	{
+		util::pool_unique_ptr<session_info> sess_1 = mpool.alloc_unique<session_info>(USER_GRP_NAME, g_sinfo_1.id, g_sinfo_1.s_name, g_sinfo_1.u_name, g_sinfo_1.role);
+		ASSERT_TRUE(sess_1);
+		EXPECT_EQ(sess_1->_sess_name, g_sinfo_1.s_name);
+
+		util::pool_unique_ptr<session_info> sess_2 = std::move(sess_1);
+		EXPECT_FALSE(sess_1);
+		EXPECT_EQ(sess_2->_id, g_sinfo_1.id);
+
+		// unique handle can be shared later.
+		util::pool_ptr<session_info> shared_sess = std::move(sess_2);
+		EXPECT_FALSE(sess_2);
+		EXPECT_EQ(shared_sess.use_count(), 1);
+
+		util::pool_unique_ptr<room_info> room = mpool.alloc_unique<room_info>(USER_GRP_NAME, g_rinfo_1.id, g_rinfo_1.r_name, g_rinfo_1.host);
+		EXPECT_EQ(mpool.get_alloc_cnt(), 2);
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+#ifdef MPOOL_DEBUG_GRP_NAME
+	// mismatched group name returns empty handle.
+	util::pool_ptr<user_info> user = mpool.alloc_ptr<user_info>(ROOM_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+	EXPECT_FALSE(user);
+#endif
+}
+
+TEST(MemoryPoolTest, BatchAllocRelease)
+{
+	/*
+	 * "alloc_n()" reserves every node with one lock and constructs them with arguments made by generator.
+	 * If count nodes can't be reserved, nothing is allocated. "release_n()" returns every node with one lock.
+	 */
+	const std::uint32_t batch_cnt = 100;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, 8);
+	{
+		std::vector<util::pool_unique_ptr<user_info>> vec_user = mpool.alloc_n<user_info>(USER_GRP_NAME, batch_cnt, [](std::uint32_t idx) {
+				return std::make_tuple(static_cast<int>(idx), g_uinfo_3.u_name, g_uinfo_3.gender, g_uinfo_3.country, g_uinfo_3.address);
+			});
+
+		ASSERT_EQ(vec_user.size(), batch_cnt);
+		for(std::uint32_t idx = 0; idx < batch_cnt; idx++)
+		{
+			ASSERT_TRUE(vec_user[idx]);
+			EXPECT_EQ(vec_user[idx]->_age, static_cast<int>(idx));
+			EXPECT_EQ(vec_user[idx]->_address, g_uinfo_3.address);
+		}
+
+		EXPECT_EQ(mpool.get_alloc_cnt(), batch_cnt);
+		EXPECT_EQ(mpool.get_cur_byte(), sizeof(user_info) * batch_cnt);
+
+		mpool.release_n(vec_user);
+		EXPECT_TRUE(vec_user.empty());
+		EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+		EXPECT_EQ(mpool.get_pool_size(), batch_cnt);
+	}
+
+	// the second batch reuses freed nodes, and only the rest is carved.
+	{
+		std::vector<util::pool_unique_ptr<user_info>> vec_user = mpool.alloc_n<user_info>(USER_GRP_NAME, batch_cnt + 10, [](std::uint32_t idx) {
+				return std::make_tuple(static_cast<int>(idx), g_uinfo_1.u_name, g_uinfo_1.gender);
+			});
+
+		ASSERT_EQ(vec_user.size(), batch_cnt + 10);
+		EXPECT_EQ(mpool.get_pool_size(), 0);
+		EXPECT_EQ(mpool.get_cur_byte(), sizeof(user_info) * (batch_cnt + 10));
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	// over the capacity
+	std::uint32_t over_cnt = mpool.get_avail_max_byte() / sizeof(user_info) + 1;
+	std::vector<util::pool_unique_ptr<user_info>> vec_user = mpool.alloc_n<user_info>(USER_GRP_NAME, over_cnt, [](std::uint32_t idx) {
+			return std::make_tuple(static_cast<int>(idx), g_uinfo_1.u_name, g_uinfo_1.gender);
+		});
+
+	EXPECT_TRUE(vec_user.empty());
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	// a throw in the middle returns every node. (constructed ones and the rest of the run)
+	std::uint32_t pool_size      = mpool.get_pool_size();
+	std::uint64_t stat_alloc_cnt = mpool.get_stat().alloc_cnt;
+	EXPECT_THROW(mpool.alloc_n<user_info>(USER_GRP_NAME, 20, [](std::uint32_t idx) {
+			if(10 == idx) {
+				throw std::runtime_error("gen failed");
+			}
+
+			return std::make_tuple(static_cast<int>(idx), g_uinfo_1.u_name, g_uinfo_1.gender);
+		}), std::runtime_error);
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+	EXPECT_EQ(mpool.get_pool_size(), pool_size);
+	EXPECT_EQ(mpool.get_stat().alloc_cnt, stat_alloc_cnt + 10);
+
+	// node of another pool is not taken by release_n, it goes back to its own pool.
+	util::memory_pool_c other_mpool(USER_GRP_NAME, 1);
+	{
+		std::vector<util::pool_unique_ptr<user_info>> vec_mixed = mpool.alloc_n<user_info>(USER_GRP_NAME, 3, [](std::uint32_t idx) {
+				return std::make_tuple(static_cast<int>(idx), g_uinfo_1.u_name, g_uinfo_1.gender);
+			});
+
+		vec_mixed.push_back(other_mpool.alloc_unique<user_info>(USER_GRP_NAME, g_uinfo_2.age, g_uinfo_2.u_name, g_uinfo_2.gender));
+		EXPECT_EQ(other_mpool.get_alloc_cnt(), 1);
+
+		mpool.release_n(vec_mixed);
+		EXPECT_TRUE(vec_mixed.empty());
+		EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+		EXPECT_EQ(other_mpool.get_alloc_cnt(), 0);
+		EXPECT_EQ(other_mpool.get_pool_size(), 1);
+	}
+}
+
+TEST(MemoryPoolTest, GrowableChunk)
+{
+	/*
+	 * With growth policy, a new chunk is mapped when the current chunk is full, until total page count reaches max_page_cnt.
+	 * LINEAR maps the same page count as the first chunk, DOUBLE maps twice of the last chunk.
+	 */
+	const uint64_t page_size  = sysconf(_SC_PAGESIZE);
+	const uint64_t block_size = sizeof(user_info);
+
+	util::mpool_option_st option;
+	option.use_page_cnt = 1;
+	option.growth       = util::MPOOL_GROWTH::LINEAR;
+	option.max_page_cnt = 4;
+
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		std::vector<std::shared_ptr<user_info>> vec_user_info;
+		while(true)
+		{
+			std::shared_ptr<user_info> user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+			if(nullptr == user) {
+				break;
+			}
+
+			vec_user_info.push_back(user);
+		}
+
+		EXPECT_EQ(mpool.get_chunk_cnt(), 4);
+		EXPECT_EQ(mpool.get_avail_max_byte(), page_size * 4);
+		EXPECT_EQ(vec_user_info.size(), (page_size / block_size) * 4);
+
+		// every node is still valid after growth.
+		EXPECT_EQ(vec_user_info.front()->_user_name, g_uinfo_1.u_name);
+		EXPECT_EQ(vec_user_info.back()->_user_name, g_uinfo_1.u_name);
+	}
+
+	option.growth       = util::MPOOL_GROWTH::DOUBLE;
+	option.max_page_cnt = 6;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		std::vector<std::shared_ptr<user_info>> vec_user_info;
+		while(true)
+		{
+			std::shared_ptr<user_info> user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+			if(nullptr == user) {
+				break;
+			}
+
+			vec_user_info.push_back(user);
+		}
+
+		// page count of chunks: 1, 2, 3(capped)
+		EXPECT_EQ(mpool.get_chunk_cnt(), 3);
+		EXPECT_EQ(mpool.get_avail_max_byte(), page_size * 6);
+		EXPECT_EQ(vec_user_info.size(), (page_size / block_size) + (page_size * 2 / block_size) + (page_size * 3 / block_size));
+	}
+}
+
+TEST(MemoryPoolTest, MappingOption)
+{
+	/*
+	 * Without pre-fault, no usable page is resident until the first touch.
+	 * With pre-fault(or populate), every usable page is resident right after construction, and the faults are counted.
+	 * huge-page and mlock depend on the system setting, so only the counters are checked.
+	 */
+	const uint32_t page_cnt = 16;
+
+	util::mpool_option_st option;
+	option.use_page_cnt = page_cnt;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		EXPECT_EQ(mpool.get_mapped_page_cnt(), page_cnt);
+		EXPECT_EQ(mpool.get_resident_page_cnt(), 0);
+		EXPECT_EQ(mpool.get_prefault_cnt(), 0);
+
+		std::shared_ptr<user_info> user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+		EXPECT_EQ(mpool.get_resident_page_cnt(), 1);
+	}
+
+	option.use_prefault  = true;
+	option.use_huge_page = true;
+	option.use_mlock     = true;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		EXPECT_EQ(mpool.get_resident_page_cnt(), page_cnt);
+		EXPECT_GT(mpool.get_prefault_cnt(), 0);
+		EXPECT_LE(mpool.get_huge_chunk_cnt(), 1);
+		EXPECT_LE(mpool.get_locked_chunk_cnt(), 1);
+	}
+
+	option.use_prefault  = false;
+	option.use_huge_page = false;
+	option.use_mlock     = false;
+	option.use_populate  = true;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+		EXPECT_EQ(mpool.get_resident_page_cnt(), page_cnt);
+	}
+}
+
+TEST(MemoryPoolTest, ThreadCache)
+{
+	/*
+	 * With thread-cache option, alloc/free pairs are handled in per-thread stacks.
+	 * The counters of memory-pool must report the same totals as the pool without thread-cache,
+	 * and nodes cached by a terminated thread must return to the pool.
+	 */
+	const int thread_cnt    = 4;
+	const int loop_cnt      = 1000;
+	const int keep_node_cnt = 100;
+
+	util::mpool_option_st option;
+	option.use_page_cnt     = 64;
+	option.use_thread_cache = true;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+	ASSERT_TRUE(mpool.is_thread_cache());
+
+	std::vector<std::thread> vec_thread;
+	for(int t = 0; t < thread_cnt; t++)
+	{
+		vec_thread.emplace_back([&mpool, loop_cnt, keep_node_cnt]() {
+			std::vector<std::shared_ptr<session_info>> vec_sess;
+			for(int i = 0; i < loop_cnt; i++)
+			{
+				std::shared_ptr<session_info> sess = mpool.alloc<session_info>(USER_GRP_NAME, i, g_sinfo_1.s_name, g_sinfo_1.u_name, g_sinfo_1.role);
+				ASSERT_NE(sess, nullptr);
+				EXPECT_EQ(sess->_id, i);
+
+				vec_sess.push_back(sess);
+				if(keep_node_cnt <= vec_sess.size()) {
+					vec_sess.clear();
+				}
+			}
+		});
+	}
+
+	for(auto& th : vec_thread) {
+		th.join();
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	// every carved node is in the pool again.
+	uint64_t block_cnt = mpool.get_cur_byte() / sizeof(session_info);
+	EXPECT_EQ(mpool.get_pool_size(true), block_cnt);
+	EXPECT_LE(block_cnt, thread_cnt * keep_node_cnt + thread_cnt * util::MPOOL_TCACHE_MAX_CNT);
+
+	// nodes in thread-cache of current thread are also counted.
+	{
+		std::shared_ptr<room_info> room_1 = mpool.alloc<room_info>(USER_GRP_NAME, g_rinfo_1.id, g_rinfo_1.r_name, g_rinfo_1.host);
+		std::shared_ptr<room_info> room_2 = mpool.alloc<room_info>(USER_GRP_NAME, g_rinfo_2.id, g_rinfo_2.r_name, g_rinfo_2.host);
+		EXPECT_EQ(mpool.get_alloc_cnt(), 2);
+	}
+
+	// empty pool carves a whole batch into the thread-cache under one lock.
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+	EXPECT_EQ(mpool.get_pool_size(true), block_cnt + util::MPOOL_TCACHE_BATCH_CNT);
+}
+
+TEST(MemoryPoolTest, AlignedAlloc)
+{
+	/*
+	 * Over-aligned type(alignas(64)) must get an aligned address even when it is mixed with other types, and the padding is counted in adjust_byte.
+	 * With align_byte option, every node of the pool is aligned to cache-line.
+	 */
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, 4);
+
+		std::vector<std::shared_ptr<tick_info>> vec_tick_info;
+		std::vector<std::shared_ptr<counter_info>> vec_counter_info;
+		for(int i = 0; i < 5; i++)
+		{
+			vec_tick_info.push_back(mpool.alloc<tick_info>(USER_GRP_NAME, i, i + 1));
+			vec_counter_info.push_back(mpool.alloc<counter_info>(USER_GRP_NAME, i));
+		}
+
+		for(auto& counter : vec_counter_info)
+		{
+			ASSERT_NE(counter, nullptr);
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(counter.get()) % alignof(counter_info), 0);
+		}
+
+		EXPECT_GT(mpool.get_adjust_byte(), 0);
+
+		// reused node of the same block size is also aligned.
+		vec_counter_info.clear();
+		vec_counter_info.push_back(mpool.alloc<counter_info>(USER_GRP_NAME, 10));
+		ASSERT_NE(vec_counter_info.back(), nullptr);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(vec_counter_info.back().get()) % alignof(counter_info), 0);
+	}
+
+	util::mpool_option_st option;
+	option.use_page_cnt = 4;
+	option.align_byte   = util::MPOOL_CACHE_LINE_BYTE;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+		EXPECT_EQ(mpool.get_align_byte(), util::MPOOL_CACHE_LINE_BYTE);
+
+		std::shared_ptr<user_info> user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender);
+		std::shared_ptr<room_info> room = mpool.alloc<room_info>(USER_GRP_NAME, g_rinfo_1.id, g_rinfo_1.r_name, g_rinfo_1.host);
+		ASSERT_NE(user, nullptr);
+		ASSERT_NE(room, nullptr);
+
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(user.get()) % util::MPOOL_CACHE_LINE_BYTE, 0);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(room.get()) % util::MPOOL_CACHE_LINE_BYTE, 0);
+
+		uint64_t user_block = (sizeof(user_info) + util::MPOOL_CACHE_LINE_BYTE - 1) / util::MPOOL_CACHE_LINE_BYTE * util::MPOOL_CACHE_LINE_BYTE;
+		uint64_t room_block = (sizeof(room_info) + util::MPOOL_CACHE_LINE_BYTE - 1) / util::MPOOL_CACHE_LINE_BYTE * util::MPOOL_CACHE_LINE_BYTE;
+		EXPECT_EQ(mpool.get_adjust_byte(), (user_block - sizeof(user_info)) + (room_block - sizeof(room_info)));
+	}
+
+	// not power of two falls back to natural alignment.
+	option.align_byte = 48;
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+	EXPECT_EQ(mpool.get_align_byte(), sizeof(void*));
+}
+
+TEST(MemoryPoolTest, TrimPage)
+{
+	/*
+	 * trim() returns pages without live node to OS, and reports reclaimed resident bytes.
+	 * Pages which hold a live node are kept, and trimmed pages are carved again by later alloc.
+	 */
+	const uint64_t page_size = sysconf(_SC_PAGESIZE);
+	const uint32_t page_cnt  = 16;
+
+	util::mpool_option_st option;
+	option.use_page_cnt = page_cnt;
+	option.trim_advice  = util::MPOOL_TRIM::DONTNEED;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+	std::shared_ptr<user_info> keep_user = mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_2.age, g_uinfo_2.u_name, g_uinfo_2.gender);
+	ASSERT_NE(keep_user, nullptr);
+
+	std::vector<std::shared_ptr<packet_info>> vec_packet_info;
+	for(int i = 0; i < 12; i++)
+	{
+		vec_packet_info.push_back(mpool.alloc<packet_info>(USER_GRP_NAME, i));
+		ASSERT_NE(vec_packet_info.back(), nullptr);
+		vec_packet_info.back()->_payload[0] = 'x';
+	}
+
+	uint64_t resident_cnt = mpool.get_resident_page_cnt();
+	uint64_t cur_byte     = mpool.get_cur_byte();
+	EXPECT_GE(resident_cnt, 6);
+
+	// nothing to trim while every page has a live node.
+	EXPECT_EQ(mpool.trim(), 0);
+
+	vec_packet_info.clear();
+	uint64_t reclaim_byte = mpool.trim();
+
+	EXPECT_GT(reclaim_byte, 0);
+	EXPECT_EQ(reclaim_byte % page_size, 0);
+	EXPECT_EQ(mpool.get_trim_byte(), reclaim_byte);
+	EXPECT_EQ(mpool.get_resident_page_cnt(), resident_cnt - (reclaim_byte / page_size));
+	EXPECT_LT(mpool.get_cur_byte(), cur_byte);
+	EXPECT_EQ(mpool.trim(), 0);
+
+	// live node is untouched.
+	EXPECT_EQ(keep_user->_age, g_uinfo_2.age);
+	EXPECT_EQ(keep_user->_user_name, g_uinfo_2.u_name);
+
+	// trimmed pages are reused before the rest of chunk.
+	for(int i = 0; i < 12; i++)
+	{
+		vec_packet_info.push_back(mpool.alloc<packet_info>(USER_GRP_NAME, i));
+		ASSERT_NE(vec_packet_info.back(), nullptr);
+		EXPECT_EQ(vec_packet_info.back()->_seq, i);
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 13);
+	EXPECT_EQ(mpool.get_chunk_cnt(), 1);
+
+	// madvise fails on mlock-ed pages, and their free nodes stay in the pool.
+	option.use_mlock = true;
+	{
+		util::memory_pool_c lock_mpool(USER_GRP_NAME, option);
+		{
+			std::vector<std::shared_ptr<packet_info>> vec_lock_packet_info;
+			for(int i = 0; i < 12; i++) {
+				vec_lock_packet_info.push_back(lock_mpool.alloc<packet_info>(USER_GRP_NAME, i));
+			}
+		}
+
+		// nothing is reclaimed when the pages are really locked. (mlock is a no-op under some sanitizers)
+		uint32_t free_cnt = lock_mpool.get_pool_size(true);
+		if(0 == lock_mpool.trim()) {
+			EXPECT_EQ(lock_mpool.get_pool_size(true), free_cnt);
+		}
+	}
+	option.use_mlock = false;
+
+	// background trim with lazy advice.
+	option.trim_advice      = util::MPOOL_TRIM::FREE;
+	option.trim_interval_ms = 10;
+	{
+		util::memory_pool_c bg_mpool(USER_GRP_NAME, option);
+		{
+			std::vector<std::shared_ptr<packet_info>> vec_bg_packet_info;
+			for(int i = 0; i < 12; i++)
+			{
+				vec_bg_packet_info.push_back(bg_mpool.alloc<packet_info>(USER_GRP_NAME, i));
+				vec_bg_packet_info.back()->_payload[0] = 'x';
+			}
+		}
+
+		for(int i = 0; i < 200 && 0 == bg_mpool.get_trim_byte(); i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		EXPECT_GT(bg_mpool.get_trim_byte(), 0);
+	}
+}
+
+TEST(MemoryPoolTest, StatSnapshot)
+{
+	/*
+	 * get_stat() reports per size-class live/high-water/reuse/bump counts, failed alloc and lock contention without _mpool_lock.
+	 * counts served by thread-caches are included in the same snapshot.
+	 */
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, 1);
+
+		std::vector<std::shared_ptr<user_info>> vec_user_info;
+		for(int i = 0; i < 10; i++) {
+			vec_user_info.push_back(mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender));
+		}
+
+		vec_user_info.resize(5);
+		for(int i = 0; i < 3; i++) {
+			vec_user_info.push_back(mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_2.age, g_uinfo_2.u_name, g_uinfo_2.gender));
+		}
+
+		// exhaust the pool by big nodes.
+		std::vector<std::shared_ptr<packet_info>> vec_packet_info;
+		while(true)
+		{
+			std::shared_ptr<packet_info> packet = mpool.alloc<packet_info>(USER_GRP_NAME, 0);
+			if(nullptr == packet) {
+				break;
+			}
+
+			vec_packet_info.push_back(packet);
+		}
+
+		util::mpool_stat_st stat = mpool.get_stat();
+		ASSERT_EQ(stat.vec_class_stat.size(), 2);
+
+		const util::mpool_class_stat_st& user_stat = stat.vec_class_stat[0];
+		EXPECT_EQ(user_stat.block_size, sizeof(user_info));
+		EXPECT_EQ(user_stat.alloc_cnt, 13);
+		EXPECT_EQ(user_stat.live_cnt, 8);
+		EXPECT_EQ(user_stat.high_water_cnt, 10);
+		EXPECT_EQ(user_stat.bump_cnt, 10);
+		EXPECT_EQ(user_stat.reuse_cnt, 3);
+
+		const util::mpool_class_stat_st& packet_stat = stat.vec_class_stat[1];
+		EXPECT_EQ(packet_stat.block_size, 0);
+		EXPECT_EQ(packet_stat.live_cnt, vec_packet_info.size());
+
+		EXPECT_EQ(stat.live_cnt, mpool.get_alloc_cnt());
+		EXPECT_EQ(stat.fail_cnt, 1);
+		EXPECT_EQ(stat.cur_byte, mpool.get_cur_byte());
+		EXPECT_EQ(stat.high_water_byte, mpool.get_cur_byte());
+		EXPECT_DOUBLE_EQ(stat.get_reuse_ratio(), 3.0 / stat.alloc_cnt);
+		EXPECT_EQ(stat.lock_cnt, stat.alloc_cnt + 5 + 1);
+	}
+
+	util::mpool_option_st option;
+	option.use_page_cnt     = 64;
+	option.use_thread_cache = true;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		std::vector<std::thread> vec_thread;
+		for(int t = 0; t < 4; t++)
+		{
+			vec_thread.emplace_back([&mpool]() {
+				for(int i = 0; i < 1000; i++) {
+					std::shared_ptr<room_info> room = mpool.alloc<room_info>(USER_GRP_NAME, i, g_rinfo_1.r_name, g_rinfo_1.host);
+				}
+			});
+		}
+
+		// scrape while threads are running.
+		for(int i = 0; i < 10; i++)
+		{
+			util::mpool_stat_st stat = mpool.get_stat();
+			EXPECT_LE(stat.live_cnt, 4);
+			EXPECT_LE(stat.contention_cnt, stat.lock_cnt);
+		}
+
+		for(auto& th : vec_thread) {
+			th.join();
+		}
+
+		util::mpool_stat_st stat = mpool.get_stat();
+		EXPECT_EQ(stat.alloc_cnt, 4000);
+		EXPECT_EQ(stat.live_cnt, 0);
+		EXPECT_LE(stat.bump_cnt, 4 * util::MPOOL_TCACHE_BATCH_CNT);
+		EXPECT_LT(stat.lock_cnt, 4000);
+	}
+}
+
+TEST(MemoryPoolTest, PmrResource)
+{
+	/*
+	 * mpool_resource_c serves std::pmr containers from the mmap region of pool.
+	 * buffers of containers inside a pooled object come from the same pool, and freed buffers are recycled by size-class.
+	 */
+	util::mpool_option_st option;
+	option.use_page_cnt = 16;
+	option.growth       = util::MPOOL_GROWTH::LINEAR;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+	util::mpool_resource_c resource(mpool);
+	{
+		std::pmr::vector<std::uint64_t> vec_number(&resource);
+		for(std::uint64_t i = 0; i < 1000; i++) {
+			vec_number.push_back(i);
+		}
+
+		std::pmr::map<int, std::pmr::string> map_name(&resource);
+		for(int i = 0; i < 100; i++) {
+			map_name.emplace(i, std::pmr::string("name_which_is_longer_than_sso_buffer_" + std::to_string(i), &resource));
+		}
+
+		EXPECT_EQ(vec_number[999], 999);
+		EXPECT_EQ(map_name[42], "name_which_is_longer_than_sso_buffer_42");
+		EXPECT_GT(mpool.get_alloc_cnt(), 200);
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+	uint64_t cur_byte = mpool.get_cur_byte();
+
+	// same requests are served by recycled blocks.
+	{
+		std::pmr::map<int, std::pmr::string> map_name(&resource);
+		for(int i = 0; i < 100; i++) {
+			map_name.emplace(i, std::pmr::string("name_which_is_longer_than_sso_buffer_" + std::to_string(i), &resource));
+		}
+	}
+
+	EXPECT_EQ(mpool.get_cur_byte(), cur_byte);
+
+	// pooled object keeps its buffers in the same pool.
+	{
+		util::pool_unique_ptr<chat_info> chat = mpool.alloc_unique<chat_info>(USER_GRP_NAME, &resource);
+		chat->_message.assign(200, 'm');
+		chat->_vec_receiver.assign(64, 7);
+
+		EXPECT_EQ(mpool.get_alloc_cnt(), 3);
+	}
+
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	util::mpool_resource_c other_resource(mpool);
+	util::memory_pool_c other_mpool(ROOM_GRP_NAME, 1);
+	util::mpool_resource_c foreign_resource(other_mpool);
+	EXPECT_TRUE(resource.is_equal(other_resource));
+	EXPECT_FALSE(resource.is_equal(foreign_resource));
+	EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+
+	// exhausted pool throws as memory_resource requires.
+	EXPECT_THROW(static_cast<void>(foreign_resource.allocate(64 * 1024)), std::bad_alloc);
+	EXPECT_EQ(other_mpool.alloc_byte(8, 3), nullptr);
+}
+
+TEST(MemoryPoolTest, RemoteFree)
+{
+	/*
+	 * with use_remote_free, a thread releasing objects allocated by another thread never takes _mpool_lock.
+	 * freed nodes wait on a lock-free list, and the allocating thread reclaims them in batch when its free-list misses.
+	 */
+	util::mpool_option_st option;
+	option.use_page_cnt    = 64;
+	option.use_remote_free = true;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+	ASSERT_TRUE(mpool.is_remote_free());
+
+	// the first allocating thread owns the pool, and its own free goes to the free-list directly.
+	{
+		std::shared_ptr<room_info> room = mpool.alloc<room_info>(USER_GRP_NAME, 0, g_rinfo_1.r_name, g_rinfo_1.host);
+		std::shared_ptr<room_info> other_room = mpool.alloc<room_info>(USER_GRP_NAME, 1, g_rinfo_1.r_name, g_rinfo_1.host);
+
+		std::uint64_t lock_cnt = mpool.get_stat().lock_cnt;
+		room.reset();
+		EXPECT_EQ(mpool.get_stat().lock_cnt, lock_cnt + 1);
+
+		std::thread([&other_room]() { other_room.reset(); }).join();
+		EXPECT_EQ(mpool.get_stat().lock_cnt, lock_cnt + 1);
+		EXPECT_EQ(mpool.get_pool_size(true), 2);
+	}
+
+	const int PRODUCE_CNT  = 20000;
+	const int CONSUMER_CNT = 4;
+
+	std::mutex                             queue_lock;
+	std::vector<std::shared_ptr<room_info>> queue;
+	std::atomic<bool>                      is_done{false};
+
+	std::vector<std::thread> vec_thread;
+	for(int t = 0; t < CONSUMER_CNT; t++)
+	{
+		vec_thread.emplace_back([&]() {
+			while(true)
+			{
+				std::vector<std::shared_ptr<room_info>> batch;
+				{
+					std::lock_guard<std::mutex> guard(queue_lock);
+					batch.swap(queue);
+				}
+
+				if(true == batch.empty() && true == is_done.load()) {
+					break;
+				}
+
+				batch.clear(); // released by consumer.
+			}
+		});
+	}
+
+	std::uint64_t base_lock_cnt = mpool.get_stat().lock_cnt;
+
+	int produce_cnt = 0;
+	while(produce_cnt < PRODUCE_CNT)
+	{
+		std::shared_ptr<room_info> room = mpool.alloc<room_info>(USER_GRP_NAME, produce_cnt, g_rinfo_1.r_name, g_rinfo_1.host);
+		if(nullptr == room)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::lock_guard<std::mutex> guard(queue_lock);
+		queue.push_back(std::move(room));
+		produce_cnt++;
+	}
+
+	is_done = true;
+	for(auto& th : vec_thread) {
+		th.join();
+	}
+
+	// left ones are released by the owner. (one lock for each)
+	std::size_t left_cnt = 0;
+	{
+		std::lock_guard<std::mutex> guard(queue_lock);
+		left_cnt = queue.size();
+		queue.clear();
+	}
+
+	// only allocations locked the pool, and freed nodes were reused.
+	util::mpool_stat_st stat = mpool.get_stat();
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+	EXPECT_EQ(mpool.get_pool_size(), stat.bump_cnt);
+	EXPECT_LE(stat.lock_cnt, base_lock_cnt + PRODUCE_CNT + stat.fail_cnt + left_cnt);
+	EXPECT_LT(stat.bump_cnt, PRODUCE_CNT);
+
+	// trim() reclaims what is still pending.
+	mpool.trim();
+	stat = mpool.get_stat();
+	EXPECT_EQ(stat.live_cnt, 0);
+}
+
+TEST(MemoryPoolTest, WarmUp)
+{
+	/*
+	 * warm-up carves nodes into the free-list and touches their pages in constructor(or reserve<U>),
+	 * so the first allocs never bump. warm-up doesn't raise high-water count.
+	 */
+	util::mpool_option_st option;
+	option.use_page_cnt = 64;
+	option.vec_warm_up  = {util::mpool_reserve_st{sizeof(user_info), 100, alignof(user_info)}, util::mpool_reserve_st{sizeof(packet_info), 10, alignof(packet_info)}};
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+	util::mpool_warm_up_stat_st warm_up_stat = mpool.get_warm_up_stat();
+	EXPECT_EQ(warm_up_stat.node_cnt, 110);
+	EXPECT_LT(0, warm_up_stat.fault_cnt);
+	EXPECT_LT(0, warm_up_stat.elapsed_ns);
+	EXPECT_EQ(mpool.get_pool_size(), 110);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+	util::mpool_stat_st stat = mpool.get_stat();
+	EXPECT_EQ(stat.bump_cnt, 110);
+	EXPECT_EQ(stat.alloc_cnt, 0);
+	for(const auto& class_stat : stat.vec_class_stat) {
+		EXPECT_EQ(class_stat.high_water_cnt, 0);
+	}
+
+	{
+		std::vector<std::shared_ptr<user_info>> vec_user_info;
+		for(int i = 0; i < 100; i++) {
+			vec_user_info.push_back(mpool.alloc<user_info>(USER_GRP_NAME, g_uinfo_1.age, g_uinfo_1.u_name, g_uinfo_1.gender));
+		}
+
+		std::vector<std::shared_ptr<packet_info>> vec_packet_info;
+		for(int i = 0; i < 10; i++) {
+			vec_packet_info.push_back(mpool.alloc<packet_info>(USER_GRP_NAME, i));
+		}
+
+		stat = mpool.get_stat();
+		EXPECT_EQ(stat.bump_cnt, 110);
+		EXPECT_EQ(stat.alloc_cnt, 110);
+		EXPECT_EQ(stat.vec_class_stat[0].high_water_cnt, 100);
+	}
+
+	// reserve<U> after construction. it stops when the pool is exhausted.
+	EXPECT_EQ(mpool.reserve<room_info>(50), 50);
+	EXPECT_EQ(mpool.get_warm_up_stat().node_cnt, 50);
+	EXPECT_EQ(mpool.get_pool_size(), 160);
+
+	util::memory_pool_c small_mpool(USER_GRP_NAME, 1);
+	std::uint32_t warm_cnt = small_mpool.reserve<packet_info>(100);
+	EXPECT_LT(0, warm_cnt);
+	EXPECT_GT(100, warm_cnt);
+	EXPECT_EQ(small_mpool.get_pool_size(), warm_cnt);
+}
+
+TEST(MemoryPoolTest, RecycleNode)
+{
+	/*
+	 * with recycle_max_cnt, released recycle_node_c stays constructed. reset() is called on release and assign() on reuse,
+	 * so string members keep their heap buffers. nodes over recycle_max_cnt are destructed as usual.
+	 */
+	const std::string long_name(100, 'n');
+	const std::string long_address(200, 'a');
+
+	util::mpool_option_st option;
+	option.recycle_max_cnt = 2;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME, option);
+
+		std::vector<profile_info*> vec_prev;
+		std::vector<const char*> vec_prev_buffer;
+		{
+			std::vector<util::pool_unique_ptr<profile_info>> vec_profile;
+			for(int i = 0; i < 3; i++)
+			{
+				vec_profile.push_back(mpool.alloc_unique<profile_info>(USER_GRP_NAME, long_name, long_address));
+				vec_prev.push_back(vec_profile.back().get());
+				vec_prev_buffer.push_back(vec_profile.back()->_name.data());
+			}
+
+			EXPECT_EQ(profile_info::construct_cnt, 3);
+		}
+
+		// the node over recycle_max_cnt is destructed without reset().
+		EXPECT_EQ(profile_info::destruct_cnt, 1);
+		EXPECT_EQ(profile_info::reset_cnt, 2);
+		EXPECT_EQ(mpool.get_recycle_cnt(), 2);
+		EXPECT_EQ(mpool.get_alloc_cnt(), 0);
+
+		// the last recycled node comes first, and its buffer is reused without construction.
+		std::shared_ptr<profile_info> profile = mpool.alloc<profile_info>(USER_GRP_NAME, std::string("short"), std::string("addr"));
+		EXPECT_EQ(profile.get(), vec_prev[1]);
+		EXPECT_EQ(profile->_name, "short");
+		EXPECT_EQ(profile->_name.data(), vec_prev_buffer[1]);
+		EXPECT_LE(long_address.size(), profile->_address.capacity());
+		EXPECT_EQ(profile_info::construct_cnt, 3);
+		EXPECT_EQ(mpool.get_recycle_cnt(), 1);
+		EXPECT_EQ(mpool.get_alloc_cnt(), 1);
+
+		util::mpool_stat_st stat = mpool.get_stat();
+		EXPECT_EQ(stat.alloc_cnt, 4);
+		EXPECT_EQ(stat.live_cnt, 1);
+		EXPECT_EQ(stat.bump_cnt, 3);
+
+		// derived type of profile_info is never put into the bin of profile_info, even if the bin has room.
+		mpool.alloc<vip_profile_info>(USER_GRP_NAME, long_name, long_address, 1);
+		EXPECT_EQ(profile_info::destruct_cnt, 2);
+		EXPECT_EQ(profile_info::reset_cnt, 2);
+		EXPECT_EQ(mpool.get_recycle_cnt(), 1);
+	}
+
+	// recycled nodes are destructed with the pool.
+	EXPECT_EQ(profile_info::destruct_cnt, 4);
+
+	// without recycle_max_cnt, recycle_node_c is a normal node.
+	profile_info::construct_cnt = 0;
+	profile_info::destruct_cnt  = 0;
+	{
+		util::memory_pool_c mpool(USER_GRP_NAME);
+		mpool.alloc<profile_info>(USER_GRP_NAME, long_name, long_address);
+		mpool.alloc<profile_info>(USER_GRP_NAME, long_name, long_address);
+
+		EXPECT_EQ(mpool.get_recycle_cnt(), 0);
+		EXPECT_EQ(profile_info::construct_cnt, 2);
+		EXPECT_EQ(profile_info::destruct_cnt, 2);
+	}
+}
+
+TEST(MemoryPoolTest, PerfectForward)
+{
+	/*
+	 * constructor arguments are forwarded, so move-only arguments are accepted and temporaries are moved into the node.
+	 * emplace() uses the group-name of the pool.
+	 */
+	util::memory_pool_c mpool(USER_GRP_NAME);
+
+	std::string name(64, 'n');
+	const char* name_buffer = name.data();
+
+	util::pool_unique_ptr<token_info> token = mpool.alloc_unique<token_info>(USER_GRP_NAME, std::make_unique<int>(7), std::move(name));
+	ASSERT_NE(token.get(), nullptr);
+	EXPECT_EQ(*token->_key, 7);
+	EXPECT_EQ(token->_name.data(), name_buffer); // moved, not copied.
+
+	util::pool_unique_ptr<token_info> token_2 = mpool.emplace<token_info>(std::make_unique<int>(8), std::string("token"));
+	ASSERT_NE(token_2.get(), nullptr);
+	EXPECT_EQ(*token_2->_key, 8);
+
+	std::shared_ptr<token_info> token_3 = mpool.alloc<token_info>(USER_GRP_NAME, std::make_unique<int>(9), token_2->_name);
+	EXPECT_EQ(token_3->_name, "token");
+	EXPECT_EQ(token_2->_name, "token"); // lvalue is copied.
+	EXPECT_EQ(mpool.get_alloc_cnt(), 3);
+
+	// block goes back to the pool when the constructor throws.
+	std::uint32_t pool_size = mpool.get_pool_size();
+	EXPECT_THROW(mpool.emplace<token_info>(std::unique_ptr<int>(), std::string("empty")), std::invalid_argument);
+	EXPECT_EQ(mpool.get_alloc_cnt(), 3);
+	EXPECT_EQ(mpool.get_pool_size(), pool_size + 1);
+}
+
 TEST(MemoryPoolTest, MemoryAdjustInAlloc) 
 {
 	/*
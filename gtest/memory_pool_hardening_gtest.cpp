@@ -0,0 +1,120 @@
+#ifndef MEMORY_POOL_HARDENING_GTEST_CPP
+#define MEMORY_POOL_HARDENING_GTEST_CPP
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+#include "util_memory_pool.h"
+#include "util_memory_pool.hpp"
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+const std::string USER_GRP_NAME = "USER";
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+class user_info : public util::base_node_c
+{
+	public:
+		user_info(const std::string& grp_name, int age)
+			: util::base_node_c(grp_name), _age(age) {}
+
+	public:
+		int  _age;
+		char _name[20];
+};
+
+class packet_info : public util::base_node_c
+{
+	public:
+		packet_info(const std::string& grp_name, int seq)
+			: util::base_node_c(grp_name), _seq(seq) {}
+
+	public:
+		int  _seq;
+		char _payload[2048];
+};
+
+/* ====================================================================== */
+/* =============================== GTEST ================================ */
+/* ====================================================================== */
+#ifdef MPOOL_HARDENING
+TEST(MemoryPoolHardeningTest, CleanUse)
+{
+	/*
+	 * every block has red zone and poison, but correct use reports nothing.
+	 */
+	util::mpool_option_st option;
+	option.use_page_cnt     = 4;
+	option.use_thread_cache = true;
+
+	util::memory_pool_c mpool(USER_GRP_NAME, option);
+	for(int i = 0; i < 100; i++)
+	{
+		util::pool_unique_ptr<user_info> user     = mpool.alloc_unique<user_info>(USER_GRP_NAME, i);
+		util::pool_unique_ptr<packet_info> packet = mpool.alloc_unique<packet_info>(USER_GRP_NAME, i);
+		ASSERT_TRUE(user);
+		ASSERT_TRUE(packet);
+
+		std::memset(user->_name, 'a', sizeof(user->_name));
+		std::memset(packet->_payload, 'b', sizeof(packet->_payload));
+	}
+
+	void* byte_block = mpool.alloc_byte(100, 16);
+	ASSERT_NE(byte_block, nullptr);
+	std::memset(byte_block, 'c', 100);
+	mpool.release_byte(byte_block, 100, 16);
+
+	auto vec_user_info = mpool.alloc_n<user_info>(USER_GRP_NAME, 10, [](std::uint32_t idx) { return std::make_tuple(static_cast<int>(idx)); });
+	mpool.release_n(vec_user_info);
+
+	EXPECT_EQ(mpool.get_corrupt_cnt(), 0);
+}
+
+TEST(MemoryPoolHardeningTest, Overflow)
+{
+	/*
+	 * write past the end of object breaks the canary, and it is reported on free.
+	 */
+	util::memory_pool_c mpool(USER_GRP_NAME, 4);
+
+	util::pool_unique_ptr<user_info> user = mpool.alloc_unique<user_info>(USER_GRP_NAME, 10);
+	reinterpret_cast<char*>(user.get())[sizeof(user_info)] = 'x';
+	user.reset();
+	EXPECT_EQ(mpool.get_corrupt_cnt(), 1);
+
+	util::pool_unique_ptr<packet_info> packet = mpool.alloc_unique<packet_info>(USER_GRP_NAME, 10);
+	reinterpret_cast<char*>(packet.get())[sizeof(packet_info) + 3] = 'x';
+	packet.reset();
+	EXPECT_EQ(mpool.get_corrupt_cnt(), 2);
+}
+
+TEST(MemoryPoolHardeningTest, UseAfterFree)
+{
+	/*
+	 * write to a freed node breaks the poison, and it is reported when the node is reused.
+	 */
+	util::memory_pool_c mpool(USER_GRP_NAME, 4);
+
+	util::pool_unique_ptr<user_info> user = mpool.alloc_unique<user_info>(USER_GRP_NAME, 10);
+	user_info* dangling = user.get();
+	user.reset();
+	EXPECT_EQ(mpool.get_corrupt_cnt(), 0);
+
+	dangling->_age = 20;
+
+	util::pool_unique_ptr<user_info> reused = mpool.alloc_unique<user_info>(USER_GRP_NAME, 30);
+	EXPECT_EQ(reused.get(), dangling);
+	EXPECT_EQ(mpool.get_corrupt_cnt(), 1);
+}
+#endif
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef OBJECT_POOL_GTEST_CPP
+#define OBJECT_POOL_GTEST_CPP
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "util_object_pool.h"
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+struct order_info
+{
+	order_info(std::uint64_t id, std::uint32_t price, std::uint32_t qty)
+		: id(id), price(price), qty(qty) {}
+
+	std::uint64_t id;
+	std::uint32_t price;
+	std::uint32_t qty;
+};
+
+struct alignas(64) quote_info
+{
+	std::uint64_t bid = 0;
+	std::uint64_t ask = 0;
+};
+
+struct symbol_info
+{
+	symbol_info(const std::string& name, bool is_throw) : name(name)
+	{
+		if(true == is_throw) {
+			throw std::runtime_error("symbol_info");
+		}
+	}
+
+	~symbol_info() { destruct_cnt++; }
+
+	std::string name;
+	static inline int destruct_cnt = 0;
+};
+
+/* ====================================================================== */
+/* =============================== GTEST ================================ */
+/* ====================================================================== */
+TEST(ObjectPoolTest, AllocRelease)
+{
+	/*
+	 * slot size is fixed at compile time and T needs no base class.
+	 * released slot is reused first, and a new block is added when every slot is used.
+	 */
+	util::object_pool_c<order_info, 16> opool;
+	static_assert(sizeof(order_info) == util::object_pool_c<order_info, 16>::SLOT_SIZE);
+
+	std::vector<order_info*> vec_order_info;
+	for(std::uint64_t i = 0; i < 16; i++)
+	{
+		order_info* order = opool.alloc(i, 100, 1);
+		ASSERT_NE(order, nullptr);
+		vec_order_info.push_back(order);
+	}
+
+	EXPECT_EQ(opool.get_block_cnt(), 1);
+	EXPECT_EQ(opool.get_alloc_cnt(), 16);
+
+	// slots of a block are contiguous.
+	EXPECT_EQ(vec_order_info.back() - vec_order_info.front(), 15);
+
+	order_info* released = vec_order_info[3];
+	opool.release(released);
+	vec_order_info.erase(vec_order_info.begin() + 3);
+	EXPECT_EQ(opool.get_free_cnt(), 1);
+
+	order_info* reused = opool.alloc(100, 200, 2);
+	EXPECT_EQ(reused, released);
+	EXPECT_EQ(reused->price, 200);
+	vec_order_info.push_back(reused);
+
+	vec_order_info.push_back(opool.alloc(101, 300, 3));
+	EXPECT_EQ(opool.get_block_cnt(), 2);
+	EXPECT_EQ(opool.get_capacity(), 32);
+
+	for(auto order : vec_order_info) {
+		opool.release(order);
+	}
+
+	EXPECT_EQ(opool.get_alloc_cnt(), 0);
+	EXPECT_EQ(opool.get_free_cnt(), 17);
+}
+
+TEST(ObjectPoolTest, AlignedSlot)
+{
+	/*
+	 * slot alignment follows alignof(T), and every block starts on a cache-line.
+	 */
+	using quote_pool = util::object_pool_c<quote_info, 8>;
+	static_assert(64 == quote_pool::SLOT_ALIGN);
+	static_assert(64 == quote_pool::SLOT_SIZE);
+
+	quote_pool opool;
+	for(int i = 0; i < 20; i++)
+	{
+		quote_info* quote = opool.alloc();
+		ASSERT_NE(quote, nullptr);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(quote) % alignof(quote_info), 0);
+	}
+
+	util::object_pool_c<order_info> order_pool;
+	order_info* order = order_pool.alloc(1, 1, 1);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(order) % util::OPOOL_CACHE_LINE_BYTE, 0);
+	order_pool.release(order);
+}
+
+TEST(ObjectPoolTest, UniqueAndReserve)
+{
+	/*
+	 * unique_ptr returns the object to the pool, and a throwing constructor gives the slot back.
+	 * reserve() allocates blocks in advance, so later alloc never adds a block.
+	 */
+	util::object_pool_c<symbol_info, 4> opool;
+	symbol_info::destruct_cnt = 0;
+	{
+		auto symbol = opool.alloc_unique("KRW-BTC", false);
+		ASSERT_NE(symbol, nullptr);
+		EXPECT_EQ(symbol->name, "KRW-BTC");
+		EXPECT_EQ(opool.get_alloc_cnt(), 1);
+	}
+
+	EXPECT_EQ(symbol_info::destruct_cnt, 1);
+	EXPECT_EQ(opool.get_alloc_cnt(), 0);
+
+	EXPECT_THROW(opool.alloc("KRW-ETH", true), std::runtime_error);
+	EXPECT_EQ(opool.get_alloc_cnt(), 0);
+	EXPECT_EQ(opool.get_free_cnt(), 1);
+
+	ASSERT_TRUE(opool.reserve(10));
+	std::size_t block_cnt = opool.get_block_cnt();
+	EXPECT_EQ(block_cnt, 3);
+
+	std::vector<util::object_pool_c<symbol_info, 4>::unique_ptr> vec_symbol_info;
+	for(int i = 0; i < 10; i++) {
+		vec_symbol_info.push_back(opool.alloc_unique(std::to_string(i), false));
+	}
+
+	EXPECT_EQ(opool.get_block_cnt(), block_cnt);
+	EXPECT_EQ(opool.get_alloc_cnt(), 10);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+#endif
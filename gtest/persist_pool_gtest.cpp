@@ -0,0 +1,236 @@
+#ifndef PERSIST_POOL_GTEST_CPP
+#define PERSIST_POOL_GTEST_CPP
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "util_persist_pool.h"
+
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+#define PERSIST_GRP_NAME "PERSIST"
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+struct member_info
+{
+	static constexpr std::uint32_t PERSIST_TAG = 1;
+
+	std::uint32_t age      = 0;
+	char          name[24] = {};
+};
+
+struct lobby_info
+{
+	static constexpr std::uint32_t PERSIST_TAG = 2;
+
+	std::uint32_t                     lobby_no   = 0;
+	std::uint32_t                     member_cnt = 0;
+	util::persist_ref_st<member_info> host;
+	util::persist_ref_st<lobby_info>  next;
+};
+
+static std::string make_file_path(const char* name)
+{
+	std::string file_path = std::string("/tmp/persist_pool_gtest_") + name + "_" + std::to_string(getpid());
+	std::remove(file_path.c_str());
+
+	return file_path;
+}
+
+/* ====================================================================== */
+/* =============================== GTEST ================================ */
+/* ====================================================================== */
+TEST(PersistPoolTest, Restart)
+{
+	/*
+	 * child process builds objects linked by offset references, and is killed without closing the pool.
+	 * restarted process re-attaches the file at another address, and walks the same objects without rebuilding them.
+	 */
+	std::string file_path = make_file_path("restart");
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+	if(0 == pid)
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 1024 * 1024);
+		if(false == ppool.is_open() || true == ppool.is_attached()) {
+			_exit(1);
+		}
+
+		lobby_info* prev = nullptr;
+		for(std::uint32_t i = 0; i < 100; i++)
+		{
+			member_info* host = ppool.alloc<member_info>(20 + i % 10);
+			std::snprintf(host->name, sizeof(host->name), "member_%u", i);
+
+			lobby_info* lobby = ppool.alloc<lobby_info>(i, 1u, ppool.to_ref(host), util::persist_ref_st<lobby_info>());
+			if(nullptr == prev) {
+				ppool.set_root(lobby);
+			}
+			else {
+				prev->next = ppool.to_ref(lobby);
+			}
+
+			prev = lobby;
+		}
+
+		// released slots are not walked.
+		member_info* temp = ppool.alloc<member_info>(99u);
+		ppool.release(temp);
+
+		_exit(0); // killed. (no destructor)
+	}
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		ASSERT_TRUE(ppool.is_open());
+		EXPECT_TRUE(ppool.is_attached());
+		EXPECT_FALSE(ppool.is_clean_close());
+		EXPECT_EQ(ppool.get_file_byte(), 1024 * 1024);
+		EXPECT_EQ(ppool.get_live_cnt(), 200);
+		EXPECT_EQ(ppool.get_free_cnt(), 1);
+
+		// follow references from root.
+		std::uint32_t lobby_no = 0;
+		for(lobby_info* lobby = ppool.get_root<lobby_info>(); nullptr != lobby; lobby = ppool.from_ref(lobby->next))
+		{
+			EXPECT_EQ(lobby->lobby_no, lobby_no);
+
+			member_info* host = ppool.from_ref(lobby->host);
+			ASSERT_NE(host, nullptr);
+			EXPECT_EQ(host->age, 20 + lobby_no % 10);
+			EXPECT_EQ(std::string(host->name), "member_" + std::to_string(lobby_no));
+			lobby_no++;
+		}
+
+		EXPECT_EQ(lobby_no, 100);
+
+		// walk live objects by type.
+		std::uint32_t age_sum = 0;
+		EXPECT_EQ(ppool.for_each<member_info>([&age_sum](member_info& member) { age_sum += member.age; }), 100);
+		EXPECT_EQ(age_sum, 100 * 20 + 10 * 45);
+		EXPECT_EQ(ppool.for_each<lobby_info>([](lobby_info&) {}), 100);
+
+		// free slot is reused.
+		std::uint64_t used_byte = ppool.get_used_byte();
+		member_info* member     = ppool.alloc<member_info>(30u);
+		ASSERT_NE(member, nullptr);
+		EXPECT_EQ(ppool.get_used_byte(), used_byte);
+		EXPECT_EQ(ppool.get_free_cnt(), 0);
+	}
+
+	// closed normally.
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		ASSERT_TRUE(ppool.is_open());
+		EXPECT_TRUE(ppool.is_clean_close());
+		EXPECT_EQ(ppool.get_live_cnt(), 201);
+	}
+
+	std::remove(file_path.c_str());
+}
+
+TEST(PersistPoolTest, FullAndBrokenFile)
+{
+	/*
+	 * file size is fixed, alloc fails when it is full.
+	 * a file which is not a persist pool is never attached or overwritten.
+	 */
+	std::string file_path = make_file_path("full");
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		ASSERT_TRUE(ppool.is_open());
+		EXPECT_FALSE(ppool.is_attached());
+
+		std::uint64_t alloc_cnt = 0;
+		while(nullptr != ppool.alloc<lobby_info>(static_cast<std::uint32_t>(alloc_cnt), 0u, util::persist_ref_st<member_info>(), util::persist_ref_st<lobby_info>())) {
+			alloc_cnt++;
+		}
+
+		EXPECT_LT(0, alloc_cnt);
+		EXPECT_EQ(ppool.get_live_cnt(), alloc_cnt);
+		EXPECT_LE(ppool.get_file_byte() - ppool.get_used_byte(), sizeof(util::ppool_record_st) + sizeof(lobby_info));
+	}
+
+	std::remove(file_path.c_str());
+
+	file_path = make_file_path("broken");
+	{
+		FILE* file = std::fopen(file_path.c_str(), "w");
+		ASSERT_NE(file, nullptr);
+
+		std::vector<char> garbage(8192, 'x');
+		std::fwrite(garbage.data(), 1, garbage.size(), file);
+		std::fclose(file);
+
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		EXPECT_FALSE(ppool.is_open());
+		EXPECT_EQ(ppool.alloc<member_info>(1u), nullptr);
+	}
+
+	std::remove(file_path.c_str());
+}
+
+TEST(PersistPoolTest, LockAndRecovery)
+{
+	/*
+	 * a file is mapped by only one pool at a time.
+	 * for_each() calls func without the lock, so recovery code can release objects while walking them.
+	 */
+	std::string file_path = make_file_path("lock");
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		ASSERT_TRUE(ppool.is_open());
+
+		util::persist_pool_c other_ppool(PERSIST_GRP_NAME, file_path, 0);
+		EXPECT_FALSE(other_ppool.is_open());
+
+		for(std::uint32_t i = 0; i < 10; i++) {
+			ppool.alloc<member_info>(i);
+		}
+
+		// drop odd members, and keep a copy of even ones.
+		std::uint64_t visit_cnt = ppool.for_each<member_info>([&ppool](member_info& member) {
+			if(1 == member.age % 2) {
+				ppool.release(&member);
+			}
+			else {
+				ppool.alloc<member_info>(member.age + 100);
+			}
+		});
+
+		EXPECT_EQ(visit_cnt, 10);
+		EXPECT_EQ(ppool.get_live_cnt(), 10);
+	}
+
+	// the lock is gone with the first pool.
+	{
+		util::persist_pool_c ppool(PERSIST_GRP_NAME, file_path, 0);
+		ASSERT_TRUE(ppool.is_open());
+		EXPECT_TRUE(ppool.is_attached());
+		EXPECT_EQ(ppool.get_live_cnt(), 10);
+	}
+
+	std::remove(file_path.c_str());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+#endif
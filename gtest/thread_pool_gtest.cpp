@@ -2,14 +2,53 @@
 #define THREAD_POOL_GTEST_CPP
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <array>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "util_thread_pool.h"
 
 /* ====================================================================== */
 /* ========================== DEFINE & ENUM ============================= */
 /* ====================================================================== */
+const std::chrono::seconds TASK_TIMEOUT{10};
 
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+/* counts copies of itself. a task must be moved from dispatch to execution. */
+struct copy_counter_info
+{
+	copy_counter_info(std::atomic<std::uint64_t>& copy_cnt, std::atomic<std::uint64_t>& call_cnt) : copy_cnt(copy_cnt), call_cnt(call_cnt) {}
+
+	copy_counter_info(const copy_counter_info& rhs) : copy_cnt(rhs.copy_cnt), call_cnt(rhs.call_cnt) { copy_cnt.fetch_add(1); }
+	copy_counter_info(copy_counter_info&& rhs) noexcept = default;
+
+	void operator()() { call_cnt.fetch_add(1); }
+
+	std::atomic<std::uint64_t>& copy_cnt;
+	std::atomic<std::uint64_t>& call_cnt;
+};
+
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+static bool wait_until_cnt(const std::atomic<std::uint64_t>& cnt, std::uint64_t expected)
+{
+	auto deadline = std::chrono::steady_clock::now() + TASK_TIMEOUT;
+	while(cnt.load() < expected && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return expected == cnt.load();
+}
 
 /* ====================================================================== */
 /* =============================== GTEST ================================ */
@@ -37,6 +76,292 @@ TEST(ThreadPoolTest, MemoryAdjustInAlloc)
 	EXPECT_EQ(test_data, 10);
 }
 
+TEST(ThreadPoolTest, WorkStealing)
+{
+	/*
+	 * a task dispatched inside a consumer is pushed to its own deque, and idle consumers steal from it.
+	 * binary fan-out from one root task makes every leaf run exactly once.
+	 */
+	util::thread_pool_c thread_pool;
+	ASSERT_TRUE(thread_pool.create_pool("STEAL", 4));
+
+	const std::uint32_t max_depth = 12;
+
+	std::atomic<std::uint64_t> leaf_cnt{0};
+	std::function<void(std::uint32_t)> fan_out = [&](std::uint32_t depth)
+	{
+		if(max_depth == depth)
+		{
+			// busy enough to let peers steal the sibling.
+			volatile std::uint64_t sum = 0;
+			for(std::uint32_t i = 0; i < 2000; i++) {
+				sum = sum + i;
+			}
+
+			leaf_cnt.fetch_add(1);
+			return;
+		}
+
+		thread_pool.async_dispatch(fan_out, depth + 1);
+		thread_pool.async_dispatch(fan_out, depth + 1);
+	};
+
+	ASSERT_TRUE(thread_pool.async_dispatch(fan_out, 0u));
+	EXPECT_TRUE(wait_until_cnt(leaf_cnt, 1ull << max_depth));
+	EXPECT_LT(0u, thread_pool.get_steal_cnt());
+}
+
+TEST(ThreadPoolTest, ExternalDispatch)
+{
+	/*
+	 * tasks from a non-consumer thread still go through the shared queue.
+	 */
+	util::thread_pool_c thread_pool;
+	ASSERT_TRUE(thread_pool.create_pool("EXTERNAL", 4));
+
+	std::atomic<std::uint64_t> sum{0};
+	std::atomic<std::uint64_t> done_cnt{0};
+	for(std::uint64_t i = 1; i <= 1000; i++)
+	{
+		EXPECT_TRUE(thread_pool.async_dispatch([&sum, &done_cnt](std::uint64_t value) {
+			sum.fetch_add(value);
+			done_cnt.fetch_add(1);
+		}, i));
+	}
+
+	EXPECT_TRUE(wait_until_cnt(done_cnt, 1000));
+	EXPECT_EQ(sum.load(), 1000ull * 1001 / 2);
+}
+
+TEST(ThreadPoolTest, DirectDispatch)
+{
+	/*
+	 * submitter wakes a parked consumer by itself. (no producer thread)
+	 * every consumer is parked between the rounds, so each round has to wake them up again.
+	 */
+	util::thread_pool_c thread_pool;
+	ASSERT_TRUE(thread_pool.create_pool("DIRECT", 4, util::TPOOL_DISPATCH::DIRECT));
+	EXPECT_EQ(thread_pool.get_dispatch_mode(), util::TPOOL_DISPATCH::DIRECT);
+
+	std::atomic<std::uint64_t> done_cnt{0};
+	for(std::uint64_t round = 1; round <= 20; round++)
+	{
+		for(std::uint32_t i = 0; i < 8; i++)
+		{
+			// half of them spawns one more task inside the consumer.
+			EXPECT_TRUE(thread_pool.async_dispatch([&thread_pool, &done_cnt](bool is_spawn) {
+				if(true == is_spawn) {
+					thread_pool.async_dispatch([&done_cnt]() { done_cnt.fetch_add(1); });
+				}
+
+				done_cnt.fetch_add(1);
+			}, 0 == i % 2));
+		}
+
+		EXPECT_TRUE(wait_until_cnt(done_cnt, round * 12));
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+TEST(ThreadPoolTest, SubmitFuture)
+{
+	/*
+	 * submit() delivers the result or the exception of the task through task_future_c.
+	 * then() runs on the pool, and an exception skips the continuation and reaches the last future.
+	 */
+	util::thread_pool_c thread_pool;
+	ASSERT_TRUE(thread_pool.create_pool("FUTURE", 4, util::TPOOL_DISPATCH::DIRECT));
+
+	util::task_future_c<int> sum_future = thread_pool.submit([](int lhs, int rhs) { return lhs + rhs; }, 40, 2);
+	EXPECT_TRUE(sum_future.valid());
+	EXPECT_EQ(sum_future.get(), 42);
+	EXPECT_FALSE(sum_future.valid());
+
+	util::task_future_c<int> error_future = thread_pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+	EXPECT_THROW(error_future.get(), std::runtime_error);
+
+	std::atomic<std::uint64_t> void_cnt{0};
+	util::task_future_c<void> void_future = thread_pool.submit([&void_cnt]() { void_cnt.fetch_add(1); });
+	void_future.get();
+	EXPECT_EQ(void_cnt.load(), 1);
+
+	// chain of continuations. (each one runs on a consumer thread)
+	std::atomic<std::uint64_t> pool_thread_cnt{0};
+	std::thread::id            main_thread_id = std::this_thread::get_id();
+
+	auto text_future = thread_pool.submit([]() { return 7; })
+		.then([&](int value) {
+			pool_thread_cnt.fetch_add(std::this_thread::get_id() != main_thread_id ? 1 : 0);
+			return value * 6;
+		})
+		.then([&](int value) {
+			pool_thread_cnt.fetch_add(std::this_thread::get_id() != main_thread_id ? 1 : 0);
+			return std::to_string(value);
+		});
+
+	EXPECT_EQ(text_future.get(), "42");
+	EXPECT_EQ(pool_thread_cnt.load(), 2);
+
+	std::atomic<bool> is_called{false};
+	auto skip_future = thread_pool.submit([]() -> int { throw std::logic_error("first failed"); })
+		.then([&is_called](int value) {
+			is_called.store(true);
+			return value;
+		});
+
+	EXPECT_THROW(skip_future.get(), std::logic_error);
+	EXPECT_FALSE(is_called.load());
+
+	// continuation registered after the task is done.
+	util::task_future_c<std::unique_ptr<int>> ptr_future = thread_pool.submit([]() { return std::make_unique<int>(5); });
+	ptr_future.wait();
+	EXPECT_TRUE(ptr_future.is_ready());
+	EXPECT_EQ(ptr_future.then([](std::unique_ptr<int> ptr) { return *ptr + 1; }).get(), 6);
+
+	// reference result is stored as a copy.
+	std::string name = "before";
+	util::task_future_c<std::string> name_future = thread_pool.submit([&name]() -> const std::string& { return name; });
+	name_future.wait();
+	name = "after";
+	EXPECT_EQ(name_future.then([&name](std::string value) -> std::string& { name = value; return name; }).get(), "before");
+}
+
+TEST(ThreadPoolTest, ShutdownDrain)
+{
+	/*
+	 * tasks still queued at destruction run before the consumers leave, so every future is completed.
+	 * a submitted task destroyed without running breaks its future with broken_promise.
+	 */
+	for(util::TPOOL_DISPATCH dispatch_mode : {util::TPOOL_DISPATCH::PRODUCER, util::TPOOL_DISPATCH::DIRECT})
+	{
+		std::vector<util::task_future_c<int>> vec_future;
+		std::vector<util::task_future_c<int>> vec_next_future;
+		{
+			util::thread_pool_c thread_pool;
+			ASSERT_TRUE(thread_pool.create_pool("DRAIN", 2, dispatch_mode));
+
+			for(int i = 0; i < 200; i++) {
+				vec_future.push_back(thread_pool.submit([i]() { return i; }));
+			}
+
+			for(int i = 0; i < 10; i++) {
+				vec_next_future.push_back(thread_pool.submit([i]() { return i; }).then([](int value) { return value + 1; }));
+			}
+		}
+
+		for(int i = 0; i < 200; i++)
+		{
+			EXPECT_TRUE(vec_future[i].is_ready());
+			EXPECT_EQ(vec_future[i].get(), i);
+		}
+
+		for(int i = 0; i < 10; i++) {
+			EXPECT_EQ(vec_next_future[i].get(), i + 1);
+		}
+	}
+
+	auto state = std::make_shared<util::task_state_st<int>>();
+	util::task_future_c<int> broken_future(state);
+	{
+		auto func = []() { return 1; };
+		util::submit_task_st<int, decltype(func), std::tuple<>> task(std::move(state), std::move(func), std::tuple<>());
+	}
+
+	EXPECT_TRUE(broken_future.is_ready());
+	EXPECT_THROW(broken_future.get(), std::future_error);
+}
+
+TEST(ThreadPoolTest, MoveOnlyTask)
+{
+	/*
+	 * task_c keeps a small callable inline, and a big one on heap.
+	 * tasks are only moved, so a move-only capture (std::unique_ptr) can be dispatched.
+	 */
+	int value = 0;
+	util::task_c small_task([&value]() { value++; });
+	EXPECT_TRUE(small_task.is_inline());
+
+	std::array<char, util::TASK_INLINE_BYTE + 1> big_data{};
+	util::task_c big_task([&value, big_data]() { value += 1 + big_data[0]; });
+	EXPECT_FALSE(big_task.is_inline());
+
+	util::task_c moved_task(std::move(big_task));
+	EXPECT_FALSE(static_cast<bool>(big_task));
+	small_task();
+	moved_task();
+	EXPECT_EQ(value, 2);
+
+	util::thread_pool_c thread_pool;
+	ASSERT_TRUE(thread_pool.create_pool("MOVE", 4, util::TPOOL_DISPATCH::DIRECT));
+
+	std::atomic<std::uint64_t> sum{0};
+	std::atomic<std::uint64_t> done_cnt{0};
+	for(std::uint64_t i = 1; i <= 100; i++)
+	{
+		auto ptr = std::make_unique<std::uint64_t>(i);
+		EXPECT_TRUE(thread_pool.async_dispatch([ptr = std::move(ptr), &sum, &done_cnt]() {
+			sum.fetch_add(*ptr);
+			done_cnt.fetch_add(1);
+		}));
+	}
+
+	EXPECT_TRUE(wait_until_cnt(done_cnt, 100));
+	EXPECT_EQ(sum.load(), 100ull * 101 / 2);
+
+	// no copy from dispatch to execution. (including argument and submit path)
+	std::atomic<std::uint64_t> copy_cnt{0};
+	std::atomic<std::uint64_t> call_cnt{0};
+	EXPECT_TRUE(thread_pool.async_dispatch(copy_counter_info(copy_cnt, call_cnt)));
+	EXPECT_TRUE(wait_until_cnt(call_cnt, 1));
+
+	thread_pool.submit(copy_counter_info(copy_cnt, call_cnt)).get();
+	EXPECT_EQ(call_cnt.load(), 2);
+	EXPECT_EQ(copy_cnt.load(), 0);
+
+	auto ptr_future = thread_pool.submit([ptr = std::make_unique<int>(7)]() { return *ptr * 6; });
+	EXPECT_EQ(ptr_future.get(), 42);
+}
+
+TEST(ThreadPoolTest, DispatchBulk)
+{
+	/*
+	 * a batch of callables is enqueued at once, from outside and from inside a consumer.
+	 * elements are moved, so move-only tasks are accepted.
+	 */
+	for(util::TPOOL_DISPATCH dispatch_mode : {util::TPOOL_DISPATCH::PRODUCER, util::TPOOL_DISPATCH::DIRECT})
+	{
+		util::thread_pool_c thread_pool;
+		ASSERT_TRUE(thread_pool.create_pool("BULK", 4, dispatch_mode));
+
+		std::atomic<std::uint64_t> sum{0};
+		std::atomic<std::uint64_t> done_cnt{0};
+
+		std::vector<util::task_c> vec_task;
+		for(std::uint64_t i = 1; i <= 100; i++)
+		{
+			vec_task.emplace_back([ptr = std::make_unique<std::uint64_t>(i), &sum, &done_cnt]() {
+				sum.fetch_add(*ptr);
+				done_cnt.fetch_add(1);
+			});
+		}
+
+		EXPECT_TRUE(thread_pool.dispatch_bulk(vec_task));
+		EXPECT_TRUE(wait_until_cnt(done_cnt, 100));
+		EXPECT_EQ(sum.load(), 100ull * 101 / 2);
+
+		// fan out inside a consumer with an iterator pair.
+		EXPECT_TRUE(thread_pool.async_dispatch([&thread_pool, &done_cnt]() {
+			std::vector<std::function<void()>> vec_sub_task(50, [&done_cnt]() { done_cnt.fetch_add(1); });
+			thread_pool.dispatch_bulk(vec_sub_task.begin(), vec_sub_task.end());
+		}));
+
+		EXPECT_TRUE(wait_until_cnt(done_cnt, 150));
+
+		std::vector<util::task_c> empty_task;
+		EXPECT_TRUE(thread_pool.dispatch_bulk(empty_task));
+	}
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,270 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "util_memory_pool.h"
+
+namespace util
+{
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+	// size-class: capacity is BPOOL_MIN_BYTE << index. (64B ~ 64KB)
+	const std::uint32_t BPOOL_MIN_BYTE  = 64;
+	const std::uint32_t BPOOL_CLASS_CNT = 11;
+	const std::uint32_t BPOOL_MAX_BYTE  = BPOOL_MIN_BYTE << (BPOOL_CLASS_CNT - 1);
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+	class buffer_pool_c;
+
+	/* placed in front of the bytes. released to the pool when the last handle is gone. */
+	struct alignas(16) buffer_ctrl_st
+	{
+		std::atomic<std::uint32_t> ref_cnt{1};
+		std::uint32_t              capacity = 0;
+		buffer_pool_c*             owner    = nullptr;
+
+		std::uint8_t* get_data() { return reinterpret_cast<std::uint8_t*>(this + 1); }
+	};
+
+	/*
+	 * ref-counted view of a pooled byte buffer. copy shares the storage, and slice() makes a narrower view without copying bytes.
+	 * a parsed message can keep slices of its receive buffer, and the buffer is recycled when every view is gone.
+	 * reference count is atomic, so views can move across threads. (bytes themselves are not synchronized)
+	 */
+	class byte_buffer_c
+	{
+	public:
+		/* <-- special member functions --> */
+		byte_buffer_c() = default;
+		~byte_buffer_c() { _release(); }
+
+		byte_buffer_c(const byte_buffer_c& rhs) : _ctrl(rhs._ctrl), _offset(rhs._offset), _size(rhs._size)
+		{
+			if(nullptr != _ctrl) {
+				_ctrl->ref_cnt.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		byte_buffer_c& operator=(const byte_buffer_c& rhs)
+		{
+			byte_buffer_c(rhs).swap(*this);
+			return *this;
+		}
+
+		byte_buffer_c(byte_buffer_c&& rhs) noexcept : _ctrl(std::exchange(rhs._ctrl, nullptr)), _offset(std::exchange(rhs._offset, 0)), _size(std::exchange(rhs._size, 0)) {}
+
+		byte_buffer_c& operator=(byte_buffer_c&& rhs) noexcept
+		{
+			byte_buffer_c(std::move(rhs)).swap(*this);
+			return *this;
+		}
+
+		// zero-copy view of [offset, offset + size) of this view. (clamped to this view)
+		byte_buffer_c slice(std::size_t offset, std::size_t size) const
+		{
+			offset = std::min<std::size_t>(offset, _size);
+			size   = std::min<std::size_t>(size, _size - offset);
+
+			byte_buffer_c view(*this);
+			view._offset += static_cast<std::uint32_t>(offset);
+			view._size    = static_cast<std::uint32_t>(size);
+			return view;
+		}
+
+		// size can be changed within the storage after the view begins. (ex. after recv())
+		bool resize(std::size_t size)
+		{
+			if(nullptr == _ctrl || _ctrl->capacity - _offset < size) {
+				return false;
+			}
+
+			_size = static_cast<std::uint32_t>(size);
+			return true;
+		}
+
+		void reset() { byte_buffer_c().swap(*this); }
+
+		void swap(byte_buffer_c& rhs) noexcept
+		{
+			std::swap(_ctrl, rhs._ctrl);
+			std::swap(_offset, rhs._offset);
+			std::swap(_size, rhs._size);
+		}
+
+		std::uint8_t* data() const { return nullptr == _ctrl ? nullptr : _ctrl->get_data() + _offset; }
+		std::size_t size() const { return _size; }
+		std::size_t capacity() const { return nullptr == _ctrl ? 0 : _ctrl->capacity - _offset; }
+		bool empty() const { return 0 == _size; }
+		std::uint32_t use_count() const { return nullptr == _ctrl ? 0 : _ctrl->ref_cnt.load(std::memory_order_relaxed); }
+		bool is_shared_with(const byte_buffer_c& rhs) const { return nullptr != _ctrl && _ctrl == rhs._ctrl; }
+
+		explicit operator bool() const { return nullptr != _ctrl; }
+
+	private:
+		friend class buffer_pool_c;
+
+		explicit byte_buffer_c(buffer_ctrl_st* ctrl, std::size_t size) : _ctrl(ctrl), _size(static_cast<std::uint32_t>(size)) {}
+
+		inline void _release();
+
+		buffer_ctrl_st* _ctrl   = nullptr;
+		std::uint32_t   _offset = 0;
+		std::uint32_t   _size   = 0;
+	};
+
+	/*
+	 * variable-sized byte buffers in power-of-two size-classes, carved from memory_pool_c. (same mmap region, never malloc)
+	 * a released buffer is kept in the free-list of its class, and reused by the next request of the class under the class lock only.
+	 * (classes over 1KB are bigger than size-classes of memory_pool_c, so they never go back to its large free-list on the hot path)
+	 * cached buffers return to memory_pool_c by shrink() or destructor. the pool must outlive every buffer it handed out.
+	 */
+	class buffer_pool_c
+	{
+	public:
+		/* <-- special member functions --> */
+		explicit buffer_pool_c(memory_pool_c& mpool) : _mpool(mpool) {}
+		~buffer_pool_c() { shrink(); }
+
+		buffer_pool_c()                                    = delete;
+		buffer_pool_c(const buffer_pool_c& rhs)            = delete;
+		buffer_pool_c& operator=(const buffer_pool_c& rhs) = delete;
+		buffer_pool_c(buffer_pool_c&& rhs)                 = delete;
+		buffer_pool_c& operator=(buffer_pool_c&& rhs)      = delete;
+
+		// empty buffer is returned when byte is over BPOOL_MAX_BYTE or the pool is exhausted.
+		byte_buffer_c alloc(std::size_t byte)
+		{
+			if(BPOOL_MAX_BYTE < byte) {
+				return byte_buffer_c();
+			}
+
+			std::uint32_t class_idx = get_class_idx(byte);
+			std::uint32_t capacity  = BPOOL_MIN_BYTE << class_idx;
+
+			void* block = _pop_free(class_idx);
+			if(nullptr == block)
+			{
+				block = _mpool.alloc_byte(sizeof(buffer_ctrl_st) + capacity, alignof(buffer_ctrl_st));
+				if(nullptr == block) {
+					return byte_buffer_c();
+				}
+			}
+
+			buffer_ctrl_st* ctrl = ::new(block) buffer_ctrl_st();
+			ctrl->capacity       = capacity;
+			ctrl->owner          = this;
+
+			_class_alloc_cnt[class_idx].fetch_add(1, std::memory_order_relaxed);
+			_live_cnt.fetch_add(1, std::memory_order_relaxed);
+			return byte_buffer_c(ctrl, byte);
+		}
+
+		static std::uint32_t get_class_idx(std::size_t byte)
+		{
+			std::uint32_t class_idx = 0;
+			while((static_cast<std::size_t>(BPOOL_MIN_BYTE) << class_idx) < byte) {
+				class_idx++;
+			}
+
+			return class_idx;
+		}
+
+		// return every cached buffer to memory_pool_c, and return the count.
+		std::uint64_t shrink()
+		{
+			std::uint64_t shrink_cnt = 0;
+			for(std::uint32_t class_idx = 0; class_idx < BPOOL_CLASS_CNT; class_idx++)
+			{
+				std::uint32_t capacity = BPOOL_MIN_BYTE << class_idx;
+				for(void* block = _pop_free(class_idx); nullptr != block; block = _pop_free(class_idx))
+				{
+					_mpool.release_byte(block, sizeof(buffer_ctrl_st) + capacity, alignof(buffer_ctrl_st));
+					shrink_cnt++;
+				}
+			}
+
+			return shrink_cnt;
+		}
+
+		memory_pool_c& get_pool() const { return _mpool; }
+		std::uint64_t get_live_cnt() const { return _live_cnt.load(std::memory_order_relaxed); }
+		std::uint64_t get_cached_cnt() const { return _cached_cnt.load(std::memory_order_relaxed); }
+		std::uint64_t get_class_alloc_cnt(std::uint32_t class_idx) const { return BPOOL_CLASS_CNT <= class_idx ? 0 : _class_alloc_cnt[class_idx].load(std::memory_order_relaxed); }
+
+	private:
+		friend class byte_buffer_c;
+
+		/* freed buffers of one class. the link is stored in the first bytes of the block. */
+		struct free_class_st
+		{
+			std::mutex lock;
+			void*      head = nullptr;
+		};
+
+		void* _pop_free(std::uint32_t class_idx)
+		{
+			free_class_st& free_class = _free_class[class_idx];
+
+			std::lock_guard<std::mutex> class_lock(free_class.lock);
+			void* block = free_class.head;
+			if(nullptr != block)
+			{
+				free_class.head = *reinterpret_cast<void**>(block);
+				_cached_cnt.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			return block;
+		}
+
+		void _release(buffer_ctrl_st* ctrl)
+		{
+			std::uint32_t class_idx = get_class_idx(ctrl->capacity);
+			ctrl->~buffer_ctrl_st();
+
+			void* block = ctrl;
+			{
+				free_class_st& free_class = _free_class[class_idx];
+
+				// counted under the lock, so _pop_free of this block never sees the count before it.
+				std::lock_guard<std::mutex> class_lock(free_class.lock);
+				*reinterpret_cast<void**>(block) = free_class.head;
+				free_class.head                  = block;
+				_cached_cnt.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			_live_cnt.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		memory_pool_c&             _mpool;
+		free_class_st              _free_class[BPOOL_CLASS_CNT];
+		std::atomic<std::uint64_t> _cached_cnt{0};
+		std::atomic<std::uint64_t> _live_cnt{0};
+		std::atomic<std::uint64_t> _class_alloc_cnt[BPOOL_CLASS_CNT] = {};
+	};
+
+	inline void byte_buffer_c::_release()
+	{
+		if(nullptr == _ctrl) {
+			return;
+		}
+
+		// acq_rel: writes through every view happen before the storage is reused.
+		if(1 == _ctrl->ref_cnt.fetch_sub(1, std::memory_order_acq_rel)) {
+			_ctrl->owner->_release(_ctrl);
+		}
+
+		_ctrl = nullptr;
+	}
+}
+
+#endif
@@ -1,13 +1,54 @@
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <iterator>
+
+#ifdef MPOOL_HARDENING
+#include <cstdlib>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+#endif
 
 #include "util_logger.h"
 #include "util_memory_pool.h"
 
 using namespace util;
 
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+/* guards link between memory-pool and thread-cache. (lock order: registry lock -> _mpool_lock) */
+static std::mutex g_tcache_registry_lock;
+static std::atomic<std::uint64_t> g_pool_id_seq{0};
+
+/* every thread-cache of current thread. when thread is terminated, nodes return to each pool. */
+struct util::mpool_tcache_holder_st
+{
+	std::vector<mpool_tcache_st*> vec_tcache;
+
+	~mpool_tcache_holder_st()
+	{
+		for(auto tcache : vec_tcache) {
+			memory_pool_c::_release_tcache(tcache);
+		}
+	}
+};
+
+static thread_local mpool_tcache_holder_st t_tcache_holder;
+
+/* option of the legacy constructor, only page count is given. */
+static mpool_option_st make_page_option(std::uint32_t use_page_cnt)
+{
+	mpool_option_st option;
+	option.use_page_cnt = use_page_cnt;
+	return option;
+}
+
 /* ====================================================================== */
 /* ========================== CLASS & STRUCT ============================ */
 /* ====================================================================== */
@@ -17,50 +58,1496 @@ std::uint32_t memory_pool_c::_get_pageSize()
 	return page_size;
 }
 
+void memory_pool_c::_release_tcache(mpool_tcache_st* tcache)
+{
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+
+		memory_pool_c* owner = tcache->owner.load();
+		if(nullptr != owner)
+		{
+			owner->_flush_tcache(tcache);
+
+			auto& vec_tcache = owner->_vec_tcache;
+			vec_tcache.erase(std::remove(vec_tcache.begin(), vec_tcache.end(), tcache), vec_tcache.end());
+		}
+	}
+
+	delete tcache;
+}
+
+std::uint32_t memory_pool_c::get_alloc_cnt() const
+{
+	std::int64_t alloc_cnt = _mpool_alloc_cnt.load(std::memory_order_relaxed) - _remote_release_cnt.load(std::memory_order_relaxed);
+	if(true == _use_thread_cache)
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+		for(auto tcache : _vec_tcache) {
+			alloc_cnt += tcache->alloc_delta.load(std::memory_order_relaxed);
+		}
+	}
+
+	return alloc_cnt;
+}
+
+mpool_stat_st memory_pool_c::get_stat() const
+{
+	// only counters are read. (_mpool_lock is never taken, registry lock guards the list of thread-caches)
+	std::uint64_t class_alloc_cnt[MPOOL_SIZE_CLASS_CNT + 1];
+	std::uint64_t class_free_cnt[MPOOL_SIZE_CLASS_CNT + 1];
+
+	for(std::size_t class_idx = 0; class_idx <= MPOOL_SIZE_CLASS_CNT; class_idx++)
+	{
+		class_alloc_cnt[class_idx] = _class_counter[class_idx].alloc_cnt.load(std::memory_order_relaxed);
+		class_free_cnt[class_idx]  = _class_counter[class_idx].free_cnt.load(std::memory_order_relaxed);
+	}
+
+	if(true == _use_thread_cache)
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+		for(auto tcache : _vec_tcache)
+		{
+			for(std::size_t class_idx = 0; class_idx < MPOOL_SIZE_CLASS_CNT; class_idx++)
+			{
+				class_alloc_cnt[class_idx] += tcache->class_alloc_cnt[class_idx].load(std::memory_order_relaxed);
+				class_free_cnt[class_idx] += tcache->class_free_cnt[class_idx].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	mpool_stat_st stat;
+	for(std::size_t class_idx = 0; class_idx <= MPOOL_SIZE_CLASS_CNT; class_idx++)
+	{
+		const mpool_class_counter_st& counter = _class_counter[class_idx];
+
+		mpool_class_stat_st class_stat;
+		class_stat.block_size     = class_idx < MPOOL_SIZE_CLASS_CNT ? (class_idx + 1) * _get_osBit() : 0;
+		class_stat.alloc_cnt      = class_alloc_cnt[class_idx];
+		class_stat.bump_cnt       = counter.bump_cnt.load(std::memory_order_relaxed);
+		class_stat.high_water_cnt = counter.high_water_cnt.load(std::memory_order_relaxed);
+		class_stat.live_cnt       = class_free_cnt[class_idx] < class_stat.alloc_cnt ? class_stat.alloc_cnt - class_free_cnt[class_idx] : 0;
+		class_stat.reuse_cnt      = class_stat.bump_cnt < class_stat.alloc_cnt ? class_stat.alloc_cnt - class_stat.bump_cnt : 0;
+
+		if(0 == class_stat.alloc_cnt && 0 == class_stat.bump_cnt) {
+			continue;
+		}
+
+		stat.alloc_cnt += class_stat.alloc_cnt;
+		stat.live_cnt += class_stat.live_cnt;
+		stat.reuse_cnt += class_stat.reuse_cnt;
+		stat.bump_cnt += class_stat.bump_cnt;
+		stat.vec_class_stat.push_back(class_stat);
+	}
+
+	stat.fail_cnt        = _fail_cnt.load(std::memory_order_relaxed);
+	stat.lock_cnt        = _lock_cnt.load(std::memory_order_relaxed);
+	stat.contention_cnt  = _contention_cnt.load(std::memory_order_relaxed);
+	stat.cur_byte        = _mpool_cur_byte.load(std::memory_order_relaxed);
+	stat.high_water_byte = _mpool_high_water_byte.load(std::memory_order_relaxed);
+	stat.adjust_byte     = _mpool_adjust_byte.load(std::memory_order_relaxed);
+	stat.trim_byte       = _trim_byte.load(std::memory_order_relaxed);
+
+	return stat;
+}
+
 std::uint32_t memory_pool_c::get_pool_size(bool need_lock)
 {
+	std::uint32_t cached_cnt = 0;
+	if(true == _use_thread_cache)
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+		for(auto tcache : _vec_tcache) {
+			cached_cnt += tcache->cached_cnt.load(std::memory_order_relaxed);
+		}
+	}
+
+	// remote-freed nodes are counted before they are reclaimed.
+	cached_cnt += _remote_cnt.load(std::memory_order_relaxed);
+
 	if(true == need_lock)
 	{
 		std::lock_guard pool_lock(_mpool_lock);
-		return _mpool.size();
+		return _free_cnt + cached_cnt;
 	}
 
-	return _mpool.size();
+	return _free_cnt + cached_cnt;
 }
 
-memory_pool_c::memory_pool_c(const std::string& grp_name, std::uint32_t use_page_cnt)
-	: _grp_name(grp_name)
+void memory_pool_c::_release_node(base_node_c* node)
 {
-	uint32_t page_size    = _get_pageSize();
-	_mpool_avail_max_byte = page_size * use_page_cnt;
-	_mpool_max_byte       = page_size * (use_page_cnt + 1);
+	if(this != node->_owner)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "node is not owned by this pool. grp_name:{}", _grp_name);
+		return;
+	}
 
-	// mmap return_value is void*
-	_base_ptr = mmap(nullptr, _mpool_max_byte, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if(MAP_FAILED == _base_ptr)
+#ifdef MPOOL_DEBUG_GRP_NAME
+	if(0 != node->_grp_name.compare(_grp_name))
 	{
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mmap failed. grp_name:{}/errno:{}/errstr:{}", grp_name, errno, strerror(errno));
-		_base_ptr = nullptr;
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "grp_name is weird. pivot-grp_name:{}/param-grp_name:{}", _grp_name, node->_grp_name);
+		return;
 	}
+#endif
 
-	if(-1 == mprotect(reinterpret_cast<char*>(_base_ptr) + (page_size * use_page_cnt), page_size, PROT_NONE))
+	// recycled node stays constructed. (reset() is called by _recycle_node)
+	if(0 < _recycle_max_cnt)
 	{
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mprotect failed. grp_name:{}/errno:{}/errstr:{}", grp_name, errno, strerror(errno));
-		_check_mprotect = false;
+		if(std::int32_t recycle_id = node->_recycle_id(); 0 <= recycle_id && true == _recycle_node(node, recycle_id)) {
+			return;
+		}
 	}
 
-	_last_ptr        = _base_ptr;
-	_mpool_alloc_cnt = 0;
-	_mpool_cur_byte  = 0;
+	// call destructor (virtual)
+	std::size_t block_size = node->_block_size;
+	node->~base_node_c();
+
+	_return_block(node, block_size);
 }
 
-memory_pool_c::~memory_pool_c()
+bool memory_pool_c::_recycle_node(base_node_c* node, std::int32_t recycle_id)
+{
+#ifdef MPOOL_HARDENING
+	_check_red_zone(node, node->_block_size);
+#endif
+
+	// node over recycle_max_cnt is destructed right after, so it is not reset.
+	{
+		std::unique_lock<std::mutex> pool_lock = _lock_pool();
+		if(static_cast<std::size_t>(recycle_id) < _vec_recycle.size() && _recycle_max_cnt <= _vec_recycle[recycle_id].size()) {
+			return false;
+		}
+	}
+
+	// reset() may release other nodes of this pool, so it runs without _mpool_lock.
+	node->_reset();
+
+	std::unique_lock<std::mutex> pool_lock = _lock_pool();
+	if(_vec_recycle.size() <= static_cast<std::size_t>(recycle_id)) {
+		_vec_recycle.resize(recycle_id + 1);
+	}
+
+	// the bin may be filled by other thread meanwhile.
+	std::vector<base_node_c*>& vec_node = _vec_recycle[recycle_id];
+	if(_recycle_max_cnt <= vec_node.size()) {
+		return false;
+	}
+
+	vec_node.push_back(node);
+
+	add_counter(_class_counter[_get_counter_idx(node->_block_size)].free_cnt, 1);
+	add_counter(_mpool_alloc_cnt, -1);
+	return true;
+}
+
+base_node_c* memory_pool_c::_reuse_node(std::int32_t recycle_id)
+{
+	std::unique_lock<std::mutex> pool_lock = _lock_pool();
+	if(_vec_recycle.size() <= static_cast<std::size_t>(recycle_id) || true == _vec_recycle[recycle_id].empty()) {
+		return nullptr;
+	}
+
+	base_node_c* node = _vec_recycle[recycle_id].back();
+	_vec_recycle[recycle_id].pop_back();
+
+	add_counter(_class_counter[_get_counter_idx(node->_block_size)].alloc_cnt, 1);
+	add_counter(_mpool_alloc_cnt, 1);
+	return node;
+}
+
+std::uint32_t memory_pool_c::get_recycle_cnt()
+{
+	std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+
+	std::size_t recycle_cnt = 0;
+	for(const auto& vec_node : _vec_recycle) {
+		recycle_cnt += vec_node.size();
+	}
+
+	return static_cast<std::uint32_t>(recycle_cnt);
+}
+
+base_node_c* memory_pool_c::_acquire_block(std::size_t obj_size, std::size_t align_byte)
+{
+	if(nullptr == _base_ptr || false == _check_mprotect)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "base_ptr is nullptr. OR check_mprotect is false. grp_name:{}/base_ptr:{}/check_mprotect:{}"
+				, _grp_name, _base_ptr == nullptr ? "T" : "F", _check_mprotect == true ? "T" : "F");
+		return nullptr;
+	}
+
+	base_node_c* base_node = nullptr;
+	std::size_t block_size = _get_block_size(obj_size, align_byte);
+
+	// over-aligned block skips thread-cache. (cached blocks are aligned only to _align_byte)
+	if(true == _use_thread_cache && align_byte <= _align_byte && _get_class_idx(block_size) < MPOOL_SIZE_CLASS_CNT)
+	{
+		// pop the block from thread-cache. (refill from pool in batch if it's empty)
+		mpool_tcache_st* tcache = _get_tcache();
+		if(nullptr == tcache) {
+			return nullptr;
+		}
+
+		base_node = _pop_tcache(tcache, obj_size);
+		if(nullptr == base_node) {
+			return nullptr;
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> pool_lock = _lock_pool();
+
+		base_node = _pop_free(block_size, align_byte);
+		if(nullptr == base_node)
+		{
+			base_node = _carve_node(obj_size, align_byte);
+			if(nullptr == base_node) {
+				return nullptr;
+			}
+		}
+
+		add_counter(_mpool_alloc_cnt, 1);
+		add_counter(_class_counter[_get_counter_idx(block_size)].alloc_cnt, 1);
+	}
+
+#ifdef MPOOL_HARDENING
+	_verify_node(base_node, block_size);
+#endif
+
+	return base_node;
+}
+
+void memory_pool_c::_return_block(void* block, std::size_t block_size)
+{
+#ifdef MPOOL_HARDENING
+	_check_red_zone(block, block_size);
+	_poison_node(block, block_size, false);
+#endif
+
+	base_node_c* node = reinterpret_cast<base_node_c*>(block);
+
+	// push the block into thread-cache. (flush to pool in batch if it's full)
+	if(true == _use_thread_cache && _get_class_idx(block_size) < MPOOL_SIZE_CLASS_CNT)
+	{
+		if(mpool_tcache_st* tcache = _get_tcache(); nullptr != tcache)
+		{
+			_push_tcache(tcache, block_size, node);
+			return;
+		}
+	}
+
+	// remote-free never takes _mpool_lock. (free of the owner thread goes to the free-list directly)
+	if(true == _use_remote_free && sizeof(large_node_st) <= block_size && true == _is_remote_thread())
+	{
+		large_node_st* remote_node = reinterpret_cast<large_node_st*>(block);
+		remote_node->block_size    = block_size | MPOOL_REMOTE_RELEASE_BIT;
+
+		_push_remote(remote_node, remote_node, 1, 1);
+		return;
+	}
+
+	std::unique_lock<std::mutex> pool_lock = _lock_pool();
+
+	_push_free(block_size, node);
+	add_counter(_class_counter[_get_counter_idx(block_size)].free_cnt, 1);
+
+	add_counter(_mpool_alloc_cnt, -1);
+	if (_mpool_alloc_cnt < 0) {
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "_mpool_alloc_cnt is negative number. grp_name:{}/alloc_cnt:{}", _grp_name, _mpool_alloc_cnt.load());
+	}
+}
+
+void* memory_pool_c::alloc_byte(std::size_t byte, std::size_t align_byte)
+{
+	if(0 == align_byte || 0 != (align_byte & (align_byte - 1)) || MPOOL_MAX_ALIGN_BYTE < align_byte)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "align_byte is weird. grp_name:{}/byte:{}/align_byte:{}", _grp_name, byte, align_byte);
+		return nullptr;
+	}
+
+	// zero byte request also gets a unique block.
+	byte       = std::max<std::size_t>(byte, 1);
+	align_byte = std::max<std::size_t>(align_byte, _align_byte);
+
+	void* block = _acquire_block(byte, align_byte);
+#ifdef MPOOL_HARDENING
+	if(nullptr != block) {
+		_arm_node(block, _get_block_size(byte, align_byte), byte, "byte");
+	}
+#endif
+
+	return block;
+}
+
+void memory_pool_c::release_byte(void* ptr, std::size_t byte, std::size_t align_byte)
+{
+	if(nullptr == ptr) {
+		return;
+	}
+
+	byte       = std::max<std::size_t>(byte, 1);
+	align_byte = std::max<std::size_t>(align_byte, _align_byte);
+
+	_return_block(ptr, _get_block_size(byte, align_byte));
+}
+
+mpool_warm_up_stat_st memory_pool_c::warm_up(const std::vector<mpool_reserve_st>& vec_reserve)
+{
+	mpool_warm_up_stat_st warm_up_stat;
+	if(nullptr == _base_ptr || false == _check_mprotect) {
+		return warm_up_stat;
+	}
+
+	// page-faults are counted with rusage of current thread. (same as prefault)
+	auto begin_time = std::chrono::steady_clock::now();
+	struct rusage begin_usage{};
+	getrusage(RUSAGE_THREAD, &begin_usage);
+
+	std::uint64_t request_cnt = 0;
+	{
+		std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+		for(const auto& reserve : vec_reserve)
+		{
+			std::size_t align_byte = std::max<std::size_t>(reserve.align_byte, _align_byte);
+			if(0 != (align_byte & (align_byte - 1)) || MPOOL_MAX_ALIGN_BYTE < align_byte)
+			{
+				U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "align_byte is weird. grp_name:{}/obj_size:{}/align_byte:{}", _grp_name, reserve.obj_size, reserve.align_byte);
+				continue;
+			}
+
+			request_cnt += reserve.count;
+			warm_up_stat.node_cnt += _warm_node(std::max<std::size_t>(reserve.obj_size, 1), align_byte, reserve.count);
+		}
+	}
+
+	struct rusage end_usage{};
+	getrusage(RUSAGE_THREAD, &end_usage);
+
+	warm_up_stat.fault_cnt  = (end_usage.ru_minflt - begin_usage.ru_minflt) + (end_usage.ru_majflt - begin_usage.ru_majflt);
+	warm_up_stat.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_time).count();
+	_warm_up_stat           = warm_up_stat;
+
+	U_LOG_ROTATE_FILE(util::LOG_LEVEL::INFO, "warm-up is done. grp_name:{}/request_cnt:{}/node_cnt:{}/fault_cnt:{}/elapsed_us:{}"
+			, _grp_name, request_cnt, warm_up_stat.node_cnt, warm_up_stat.fault_cnt, warm_up_stat.elapsed_ns / 1000);
+
+	return warm_up_stat;
+}
+
+std::unique_lock<std::mutex> memory_pool_c::_lock_pool()
+{
+	// contention is counted when the lock isn't acquired at the first try.
+	std::unique_lock<std::mutex> pool_lock(_mpool_lock, std::try_to_lock);
+	if(false == pool_lock.owns_lock())
+	{
+		pool_lock.lock();
+		add_counter(_contention_cnt, 1);
+	}
+
+	add_counter(_lock_cnt, 1);
+	return pool_lock;
+}
+
+void memory_pool_c::_count_out(std::size_t block_size, std::int64_t delta)
+{
+	// caller must hold _mpool_lock.
+	mpool_class_counter_st& counter = _class_counter[_get_counter_idx(block_size)];
+	add_counter(counter.out_cnt, delta);
+
+	if(std::uint64_t out_cnt = counter.out_cnt.load(std::memory_order_relaxed); counter.high_water_cnt.load(std::memory_order_relaxed) < out_cnt) {
+		counter.high_water_cnt.store(out_cnt, std::memory_order_relaxed);
+	}
+}
+
+std::uint64_t memory_pool_c::get_resident_page_cnt()
+{
+	std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+
+	uint32_t page_size         = _get_pageSize();
+	std::uint64_t resident_cnt = 0;
+
+	std::vector<unsigned char> vec_page_state;
+	for(auto& chunk : _vec_chunk)
+	{
+		// guard page is excluded.
+		std::uint64_t page_cnt = chunk.max_byte / page_size - 1;
+		vec_page_state.assign(page_cnt, 0);
+
+		if(-1 == mincore(chunk.base_ptr, page_cnt * page_size, vec_page_state.data()))
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mincore failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+			continue;
+		}
+
+		for(auto page_state : vec_page_state) {
+			resident_cnt += (page_state & 1);
+		}
+	}
+
+	return resident_cnt;
+}
+
+mpool_tcache_st* memory_pool_c::_get_tcache()
+{
+	std::vector<mpool_tcache_st*>& vec_tcache = t_tcache_holder.vec_tcache;
+	for(auto tcache : vec_tcache)
+	{
+		if(_pool_id == tcache->pool_id) {
+			return tcache;
+		}
+	}
+
+	// remove thread-cache whose pool is already destroyed.
+	vec_tcache.erase(std::remove_if(vec_tcache.begin(), vec_tcache.end(), [](mpool_tcache_st* tcache) {
+			if(nullptr != tcache->owner.load()) {
+				return false;
+			}
+
+			delete tcache;
+			return true;
+		}), vec_tcache.end());
+
+	mpool_tcache_st* tcache = new(std::nothrow) mpool_tcache_st();
+	if(nullptr == tcache)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "thread-cache alloc failed. grp_name:{}", _grp_name);
+		return nullptr;
+	}
+
+	tcache->pool_id = _pool_id;
+	tcache->owner.store(this);
+
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+		_vec_tcache.push_back(tcache);
+	}
+
+	vec_tcache.push_back(tcache);
+	return tcache;
+}
+
+base_node_c* memory_pool_c::_pop_tcache(mpool_tcache_st* tcache, std::size_t obj_size)
+{
+	std::size_t block_size  = _get_block_size(obj_size, _align_byte);
+	std::size_t class_idx   = _get_class_idx(block_size);
+	mpool_free_list_st& bin = tcache->bins[class_idx];
+
+	// refill bin from pool in batch.
+	if(nullptr == bin.head)
+	{
+		std::unique_lock<std::mutex> pool_lock = _lock_pool();
+
+		std::uint32_t move_cnt = 0;
+		for(; move_cnt < MPOOL_TCACHE_BATCH_CNT; move_cnt++)
+		{
+			base_node_c* base_node = _pop_free(block_size, _align_byte);
+			if(nullptr == base_node) {
+				break;
+			}
+
+			bin.push(base_node);
+		}
+
+		if(0 == move_cnt)
+		{
+			// pool is also empty, carve a batch under the same lock. (only the first node may grow the chunk)
+			base_node_c* base_node = _carve_node(obj_size, _align_byte);
+			if(nullptr == base_node) {
+				return nullptr;
+			}
+
+			for(move_cnt = 1; move_cnt < MPOOL_TCACHE_BATCH_CNT; move_cnt++)
+			{
+				base_node_c* next_node = _bump_node(_last_ptr, _end_ptr, obj_size, _align_byte);
+				if(nullptr == next_node) {
+					break;
+				}
+
+				bin.push(next_node);
+			}
+
+			add_counter(tcache->cached_cnt, move_cnt - 1);
+			add_counter(tcache->alloc_delta, 1);
+			add_counter(tcache->class_alloc_cnt[class_idx], 1);
+			return base_node;
+		}
+
+		add_counter(tcache->cached_cnt, move_cnt);
+	}
+
+	void* node = bin.pop();
+
+	add_counter(tcache->cached_cnt, -1);
+	add_counter(tcache->alloc_delta, 1);
+	add_counter(tcache->class_alloc_cnt[class_idx], 1);
+	return reinterpret_cast<base_node_c*>(node);
+}
+
+void memory_pool_c::_push_tcache(mpool_tcache_st* tcache, std::size_t block_size, base_node_c* node)
+{
+	std::size_t class_idx   = _get_class_idx(block_size);
+	mpool_free_list_st& bin = tcache->bins[class_idx];
+
+	bin.push(node);
+
+	add_counter(tcache->cached_cnt, 1);
+	add_counter(tcache->alloc_delta, -1);
+	add_counter(tcache->class_free_cnt[class_idx], 1);
+
+	// flush bin to pool in batch.
+	if(bin.cnt < MPOOL_TCACHE_MAX_CNT) {
+		return;
+	}
+
+	add_counter(tcache->cached_cnt, -static_cast<std::int64_t>(MPOOL_TCACHE_BATCH_CNT));
+
+	// remote-free: the batch is linked once and pushed by one CAS.
+	if(true == _use_remote_free && true == _is_remote_thread())
+	{
+		large_node_st* first = nullptr;
+		large_node_st* last  = nullptr;
+		for(std::uint32_t idx = 0; idx < MPOOL_TCACHE_BATCH_CNT; idx++)
+		{
+			large_node_st* remote_node = reinterpret_cast<large_node_st*>(bin.pop());
+			remote_node->next          = first;
+			remote_node->block_size    = block_size;
+
+			first = remote_node;
+			last  = nullptr == last ? remote_node : last;
+		}
+
+		_push_remote(first, last, MPOOL_TCACHE_BATCH_CNT, 0);
+		return;
+	}
+
+	std::unique_lock<std::mutex> pool_lock = _lock_pool();
+	for(std::uint32_t idx = 0; idx < MPOOL_TCACHE_BATCH_CNT; idx++) {
+		_push_free(block_size, reinterpret_cast<base_node_c*>(bin.pop()));
+	}
+}
+
+void memory_pool_c::_flush_tcache(mpool_tcache_st* tcache)
+{
+	std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+
+	for(std::uint32_t class_idx = 0; class_idx < MPOOL_SIZE_CLASS_CNT; class_idx++)
+	{
+		mpool_free_list_st& bin = tcache->bins[class_idx];
+		std::size_t block_size  = (class_idx + 1) * _get_osBit();
+
+		while(nullptr != bin.head) {
+			_push_free(block_size, reinterpret_cast<base_node_c*>(bin.pop()));
+		}
+
+		add_counter(_class_counter[class_idx].alloc_cnt, tcache->class_alloc_cnt[class_idx].exchange(0));
+		add_counter(_class_counter[class_idx].free_cnt, tcache->class_free_cnt[class_idx].exchange(0));
+	}
+
+	add_counter(_mpool_alloc_cnt, tcache->alloc_delta.exchange(0));
+	tcache->cached_cnt.store(0);
+}
+
+base_node_c* memory_pool_c::_pop_free(std::size_t block_size, std::size_t align_byte)
+{
+	// caller must hold _mpool_lock. remote-freed nodes are reclaimed in batch when the free-list misses.
+	if(true == _use_remote_free && std::thread::id() == _remote_owner.load(std::memory_order_relaxed)) {
+		_remote_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	}
+
+	base_node_c* base_node = _pop_free_list(block_size, align_byte);
+	if(nullptr == base_node && nullptr != _remote_head.load(std::memory_order_relaxed))
+	{
+		_drain_remote();
+		base_node = _pop_free_list(block_size, align_byte);
+	}
+
+	return base_node;
+}
+
+void memory_pool_c::_push_remote(large_node_st* first, large_node_st* last, std::uint32_t count, std::uint32_t release_cnt)
+{
+	// counters go first, so drain never makes them negative.
+	if(0 != release_cnt) {
+		_remote_release_cnt.fetch_add(release_cnt, std::memory_order_relaxed);
+	}
+
+	_remote_cnt.fetch_add(count, std::memory_order_relaxed);
+
+	large_node_st* head = _remote_head.load(std::memory_order_relaxed);
+	do {
+		last->next = head;
+	} while(false == _remote_head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool memory_pool_c::_is_remote_thread() const
+{
+	// owner is not decided yet until the first alloc, so every free is remote.
+	return std::this_thread::get_id() != _remote_owner.load(std::memory_order_relaxed);
+}
+
+void memory_pool_c::_drain_remote()
+{
+	// caller must hold _mpool_lock. (take-all exchange has no ABA problem)
+	large_node_st* node = _remote_head.exchange(nullptr, std::memory_order_acquire);
+
+	std::int64_t drain_cnt   = 0;
+	std::int64_t release_cnt = 0;
+	while(nullptr != node)
+	{
+		large_node_st* next    = node->next;
+		std::size_t block_size = node->block_size & ~MPOOL_REMOTE_RELEASE_BIT;
+
+		// released by user. (not a flushed node of thread-cache)
+		if(0 != (node->block_size & MPOOL_REMOTE_RELEASE_BIT))
+		{
+			add_counter(_class_counter[_get_counter_idx(block_size)].free_cnt, 1);
+			release_cnt++;
+		}
+
+		_push_free(block_size, reinterpret_cast<base_node_c*>(node));
+
+		drain_cnt++;
+		node = next;
+	}
+
+	add_counter(_mpool_alloc_cnt, -release_cnt);
+	_remote_release_cnt.fetch_sub(release_cnt, std::memory_order_relaxed);
+	_remote_cnt.fetch_sub(drain_cnt, std::memory_order_relaxed);
+}
+
+base_node_c* memory_pool_c::_pop_free_list(std::size_t block_size, std::size_t align_byte)
 {
-	_mpool.clear();
+	// caller must hold _mpool_lock.
+	if(std::size_t class_idx = _get_class_idx(block_size); class_idx < MPOOL_SIZE_CLASS_CNT)
+	{
+		// over-aligned node reuses the head only if it is aligned.
+		mpool_free_list_st& free_list = _free_list[class_idx];
+		if(nullptr == free_list.head || 0 != reinterpret_cast<uintptr_t>(free_list.head) % align_byte) {
+			return nullptr;
+		}
+
+		_free_cnt--;
+
+		base_node_c* base_node = reinterpret_cast<base_node_c*>(free_list.pop());
+		_track_node(base_node, block_size, 1);
+		_count_out(block_size, 1);
+		return base_node;
+	}
+
+	// large block is searched by exact block size. (rarely used)
+	for(large_node_st** link = &_large_free_list; nullptr != *link; link = &(*link)->next)
+	{
+		large_node_st* node = *link;
+		if(block_size == node->block_size && 0 == reinterpret_cast<uintptr_t>(node) % align_byte)
+		{
+			*link = node->next;
+			_free_cnt--;
 
-	int result = munmap(_base_ptr, _mpool_max_byte);
-	if(-1 == result)
+			_track_node(node, block_size, 1);
+			_count_out(block_size, 1);
+			return reinterpret_cast<base_node_c*>(node);
+		}
+	}
+
+	return nullptr;
+}
+
+void memory_pool_c::_push_free(std::size_t block_size, base_node_c* node)
+{
+	// caller must hold _mpool_lock.
+	if(std::size_t class_idx = _get_class_idx(block_size); class_idx < MPOOL_SIZE_CLASS_CNT) {
+		_free_list[class_idx].push(node);
+	}
+	else
 	{
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "munmap failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		large_node_st* large_node = reinterpret_cast<large_node_st*>(node);
+		large_node->next          = _large_free_list;
+		large_node->block_size    = block_size;
+		_large_free_list          = large_node;
 	}
+
+	_free_cnt++;
+	_track_node(node, block_size, -1);
+	_count_out(block_size, -1);
+}
+
+bool memory_pool_c::_add_chunk(std::uint32_t page_cnt)
+{
+	// caller must hold _mpool_lock. (or in constructor)
+	uint32_t page_size     = _get_pageSize();
+	std::uint64_t max_byte = static_cast<std::uint64_t>(page_size) * (page_cnt + 1);
+
+	// mmap return_value is void*
+	int map_flag   = MAP_PRIVATE | MAP_ANONYMOUS | (true == _use_populate ? MAP_POPULATE : 0);
+	void* base_ptr = mmap(nullptr, max_byte, PROT_READ | PROT_WRITE, map_flag, -1, 0);
+	if(MAP_FAILED == base_ptr)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mmap failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		return false;
+	}
+
+	void* end_ptr = reinterpret_cast<char*>(base_ptr) + (static_cast<std::uint64_t>(page_size) * page_cnt);
+	if(-1 == mprotect(end_ptr, page_size, PROT_NONE))
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mprotect failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		if(true == _vec_chunk.empty()) {
+			_check_mprotect = false;
+		}
+
+		munmap(base_ptr, max_byte);
+		return false;
+	}
+
+	_prepare_chunk(base_ptr, static_cast<std::uint64_t>(page_size) * page_cnt);
+
+	chunk_st chunk;
+	chunk.base_ptr = base_ptr;
+	chunk.max_byte = max_byte;
+
+	if(MPOOL_TRIM::NONE != _trim_advice)
+	{
+		chunk.vec_page_use.assign(page_cnt, 0);
+		chunk.vec_page_carve.assign(page_cnt, 0);
+		chunk.vec_page_free.assign(page_cnt, 0);
+	}
+
+	_vec_chunk.push_back(std::move(chunk));
+
+	std::pair<uintptr_t, std::uint32_t> chunk_index(reinterpret_cast<uintptr_t>(base_ptr), static_cast<std::uint32_t>(_vec_chunk.size() - 1));
+	_vec_chunk_index.insert(std::upper_bound(_vec_chunk_index.begin(), _vec_chunk_index.end(), chunk_index), chunk_index);
+
+	// the rest of previous chunk is never used.
+	_last_ptr = base_ptr;
+	_end_ptr  = end_ptr;
+
+	_mpool_max_byte += max_byte;
+	_mpool_avail_max_byte += static_cast<std::uint64_t>(page_size) * page_cnt;
+
+	_last_chunk_page_cnt = page_cnt;
+	_total_page_cnt += page_cnt;
+	return true;
+}
+
+void memory_pool_c::_prepare_chunk(void* base_ptr, std::uint64_t avail_byte)
+{
+	// page-faults taken by populate/prefault are counted with rusage of current thread.
+	struct rusage begin_usage{};
+	getrusage(RUSAGE_THREAD, &begin_usage);
+
+	if(true == _use_huge_page)
+	{
+		if(-1 == madvise(base_ptr, avail_byte, MADV_HUGEPAGE)) {
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "madvise(MADV_HUGEPAGE) failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		}
+		else {
+			_huge_chunk_cnt++;
+		}
+	}
+
+	if(true == _use_prefault)
+	{
+		uint32_t page_size = _get_pageSize();
+		for(std::uint64_t offset = 0; offset < avail_byte; offset += page_size) {
+			reinterpret_cast<volatile char*>(base_ptr)[offset] = 0;
+		}
+	}
+
+	if(true == _use_mlock)
+	{
+		if(-1 == mlock(base_ptr, avail_byte)) {
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "mlock failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		}
+		else {
+			_locked_chunk_cnt++;
+		}
+	}
+
+	struct rusage end_usage{};
+	getrusage(RUSAGE_THREAD, &end_usage);
+
+	_prefault_cnt += (end_usage.ru_minflt - begin_usage.ru_minflt) + (end_usage.ru_majflt - begin_usage.ru_majflt);
+}
+
+bool memory_pool_c::_grow_chunk(std::size_t block_size)
+{
+	// caller must hold _mpool_lock.
+	if(MPOOL_GROWTH::FIXED == _growth) {
+		return false;
+	}
+
+	uint32_t page_size     = _get_pageSize();
+	std::uint32_t need_cnt = (block_size + page_size - 1) / page_size;
+	std::uint32_t page_cnt = MPOOL_GROWTH::DOUBLE == _growth ? _last_chunk_page_cnt * 2 : _init_page_cnt;
+
+	page_cnt = std::max(page_cnt, need_cnt);
+	if(0 != _max_page_cnt)
+	{
+		std::uint32_t remain_cnt = _total_page_cnt < _max_page_cnt ? _max_page_cnt - _total_page_cnt : 0;
+		if(remain_cnt < need_cnt) {
+			return false;
+		}
+
+		page_cnt = std::min(page_cnt, remain_cnt);
+	}
+
+	if(false == _add_chunk(page_cnt)) {
+		return false;
+	}
+
+	U_LOG_ROTATE_FILE(util::LOG_LEVEL::INFO, "new chunk is mapped. grp_name:{}/chunk_cnt:{}/page_cnt:{}/total_page_cnt:{}", _grp_name, _vec_chunk.size(), page_cnt, _total_page_cnt);
+	return true;
+}
+
+base_node_c* memory_pool_c::_carve_node(std::size_t obj_size, std::size_t align_byte)
+{
+	// caller must hold _mpool_lock.
+	std::size_t block_size = _get_block_size(obj_size, align_byte);
+
+	// trimmed pages are reused before current chunk.
+	for(auto iter = _vec_span.begin(); iter != _vec_span.end(); )
+	{
+		base_node_c* base_node = _bump_node(iter->cur_ptr, iter->end_ptr, obj_size, align_byte);
+		if(iter->cur_ptr == iter->end_ptr) {
+			iter = _vec_span.erase(iter);
+		}
+		else {
+			++iter;
+		}
+
+		if(nullptr != base_node) {
+			return base_node;
+		}
+	}
+
+	if(base_node_c* base_node = _bump_node(_last_ptr, _end_ptr, obj_size, align_byte); nullptr != base_node) {
+		return base_node;
+	}
+
+	if(false == _grow_chunk(block_size))
+	{
+		add_counter(_fail_cnt, 1);
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "can't alloc memory in {}. max_byte:{}/cur_alloc_byte:{}/req_byte:{}", _grp_name, _mpool_avail_max_byte, _mpool_cur_byte.load(), obj_size);
+		return nullptr;
+	}
+
+	// new chunk is page-aligned.
+	return _bump_node(_last_ptr, _end_ptr, obj_size, align_byte);
+}
+
+base_node_c* memory_pool_c::_bump_node(void*& cur_ptr, void* end_ptr, std::size_t obj_size, std::size_t align_byte)
+{
+	// caller must hold _mpool_lock.
+	std::size_t block_size = _get_block_size(obj_size, align_byte);
+	std::size_t pad_size   = (align_byte - reinterpret_cast<uintptr_t>(cur_ptr) % align_byte) % align_byte;
+
+	if(reinterpret_cast<uintptr_t>(end_ptr) - reinterpret_cast<uintptr_t>(cur_ptr) < pad_size + block_size) {
+		return nullptr;
+	}
+
+	base_node_c* base_node = reinterpret_cast<base_node_c*>(reinterpret_cast<uintptr_t>(cur_ptr) + pad_size);
+#ifdef MPOOL_HARDENING
+	_poison_node(base_node, block_size, true);
+#endif
+
+	_track_carve(cur_ptr, pad_size + block_size);
+	_track_node(base_node, block_size, 1);
+	_count_out(block_size, 1);
+	add_counter(_class_counter[_get_counter_idx(block_size)].bump_cnt, 1);
+
+	// calc position
+	cur_ptr = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(cur_ptr) + pad_size + block_size);
+	add_counter(_mpool_cur_byte, pad_size + block_size);
+	add_counter(_mpool_adjust_byte, pad_size + block_size - obj_size);
+	_mpool_high_water_byte.store(std::max(_mpool_high_water_byte.load(std::memory_order_relaxed), _mpool_cur_byte.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+
+	return base_node;
+}
+
+std::uint32_t memory_pool_c::_warm_node(std::size_t obj_size, std::size_t align_byte, std::uint32_t count)
+{
+	// caller must hold _mpool_lock.
+	std::size_t block_size          = _get_block_size(obj_size, align_byte);
+	mpool_class_counter_st& counter = _class_counter[_get_counter_idx(block_size)];
+
+	// carved and freed at once, it is not a live peak.
+	std::uint64_t high_water_cnt = counter.high_water_cnt.load(std::memory_order_relaxed);
+
+	std::uint32_t warm_cnt = 0;
+	for(; warm_cnt < count; warm_cnt++)
+	{
+		base_node_c* base_node = _carve_node(obj_size, align_byte);
+		if(nullptr == base_node) {
+			break;
+		}
+
+#ifndef MPOOL_HARDENING
+		// the link write touches the first page, the rest of a multi-page block is touched here. (hardening poisons every byte)
+		uint32_t page_size        = _get_pageSize();
+		std::uintptr_t begin_addr = reinterpret_cast<std::uintptr_t>(base_node);
+		for(std::uintptr_t addr = (begin_addr / page_size + 1) * page_size; addr < begin_addr + block_size; addr += page_size) {
+			*reinterpret_cast<volatile char*>(addr) = 0;
+		}
+#endif
+
+		_push_free(block_size, base_node);
+	}
+
+	counter.high_water_cnt.store(high_water_cnt, std::memory_order_relaxed);
+	return warm_cnt;
+}
+
+bool memory_pool_c::_reserve_run(std::size_t obj_size, std::size_t align_byte, std::uint32_t count, mpool_free_list_st& run)
+{
+	// caller must hold _mpool_lock.
+	std::size_t block_size = _get_block_size(obj_size, align_byte);
+
+	// reuse freed nodes first.
+	while(run.cnt < count)
+	{
+		base_node_c* base_node = _pop_free(block_size, align_byte);
+		if(nullptr == base_node) {
+			break;
+		}
+
+		run.push(base_node);
+	}
+
+	// carve the rest as one run when current chunk has enough room.
+	std::uint64_t remain_cnt = count - run.cnt;
+	std::size_t pad_size     = (align_byte - reinterpret_cast<uintptr_t>(_last_ptr) % align_byte) % align_byte;
+
+	if(0 < remain_cnt && pad_size + (remain_cnt * block_size) <= reinterpret_cast<uintptr_t>(_end_ptr) - reinterpret_cast<uintptr_t>(_last_ptr))
+	{
+		char* run_ptr = reinterpret_cast<char*>(_last_ptr) + pad_size;
+		_track_carve(_last_ptr, pad_size + (remain_cnt * block_size));
+
+		for(std::uint64_t idx = remain_cnt; 0 < idx; idx--)
+		{
+#ifdef MPOOL_HARDENING
+			_poison_node(run_ptr + ((idx - 1) * block_size), block_size, true);
+#endif
+			run.push(run_ptr + ((idx - 1) * block_size));
+			_track_node(run_ptr + ((idx - 1) * block_size), block_size, 1);
+		}
+
+		_last_ptr = run_ptr + (remain_cnt * block_size);
+		_count_out(block_size, remain_cnt);
+		add_counter(_class_counter[_get_counter_idx(block_size)].bump_cnt, remain_cnt);
+
+		add_counter(_mpool_cur_byte, pad_size + (remain_cnt * block_size));
+		add_counter(_mpool_adjust_byte, pad_size + (remain_cnt * (block_size - obj_size)));
+		_mpool_high_water_byte.store(std::max(_mpool_high_water_byte.load(std::memory_order_relaxed), _mpool_cur_byte.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+	}
+
+	while(run.cnt < count)
+	{
+		base_node_c* base_node = _carve_node(obj_size, align_byte);
+		if(nullptr == base_node)
+		{
+			// give back every reserved node.
+			std::uint32_t reserved_cnt = run.cnt;
+			while(nullptr != run.head) {
+				_push_free(block_size, reinterpret_cast<base_node_c*>(run.pop()));
+			}
+
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "can't reserve nodes in {}. req_cnt:{}/reserved_cnt:{}", _grp_name, count, reserved_cnt);
+			return false;
+		}
+
+		run.push(base_node);
+	}
+
+	add_counter(_mpool_alloc_cnt, count);
+	add_counter(_class_counter[_get_counter_idx(block_size)].alloc_cnt, count);
+	return true;
+}
+
+void memory_pool_c::_release_run(large_node_st* run, std::uint32_t count)
+{
+	if(true == _use_remote_free && nullptr != run && true == _is_remote_thread())
+	{
+		large_node_st* last = run;
+		for(large_node_st* node = run; nullptr != node; node = node->next)
+		{
+			node->block_size |= MPOOL_REMOTE_RELEASE_BIT;
+			last = node;
+		}
+
+		_push_remote(run, last, count, count);
+		return;
+	}
+
+	std::unique_lock<std::mutex> pool_lock = _lock_pool();
+
+	while(nullptr != run)
+	{
+		large_node_st* next    = run->next;
+		std::size_t block_size = run->block_size;
+
+		_push_free(block_size, reinterpret_cast<base_node_c*>(run));
+		add_counter(_class_counter[_get_counter_idx(block_size)].free_cnt, 1);
+
+		run = next;
+	}
+
+	add_counter(_mpool_alloc_cnt, -static_cast<std::int64_t>(count));
+	if (_mpool_alloc_cnt < 0) {
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "_mpool_alloc_cnt is negative number. grp_name:{}/alloc_cnt:{}", _grp_name, _mpool_alloc_cnt.load());
+	}
+}
+
+memory_pool_c::chunk_st* memory_pool_c::_find_chunk(void* ptr)
+{
+	// mmap gives no ordering between chunks, so search the address-sorted index instead of _vec_chunk.
+	uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+	auto iter = std::upper_bound(_vec_chunk_index.begin(), _vec_chunk_index.end(), addr,
+		[](uintptr_t value, const std::pair<uintptr_t, std::uint32_t>& index) { return value < index.first; });
+	if(_vec_chunk_index.begin() == iter) {
+		return nullptr;
+	}
+
+	chunk_st& chunk = _vec_chunk[std::prev(iter)->second];
+	if(addr < reinterpret_cast<uintptr_t>(chunk.base_ptr) + chunk.max_byte) {
+		return &chunk;
+	}
+
+	return nullptr;
+}
+
+void memory_pool_c::_track_node(void* node, std::size_t block_size, std::int32_t delta)
+{
+	// caller must hold _mpool_lock.
+	if(MPOOL_TRIM::NONE == _trim_advice) {
+		return;
+	}
+
+	chunk_st* chunk = _find_chunk(node);
+	if(nullptr == chunk) {
+		return;
+	}
+
+	uint32_t page_size   = _get_pageSize();
+	uintptr_t offset     = reinterpret_cast<uintptr_t>(node) - reinterpret_cast<uintptr_t>(chunk->base_ptr);
+	std::size_t last_idx = (offset + block_size - 1) / page_size;
+
+	for(std::size_t page_idx = offset / page_size; page_idx <= last_idx; page_idx++) {
+		chunk->vec_page_use[page_idx] += delta;
+	}
+}
+
+void memory_pool_c::_track_carve(void* begin_ptr, std::size_t byte)
+{
+	// caller must hold _mpool_lock.
+	if(MPOOL_TRIM::NONE == _trim_advice || 0 == byte) {
+		return;
+	}
+
+	chunk_st* chunk = _find_chunk(begin_ptr);
+	if(nullptr == chunk) {
+		return;
+	}
+
+	uint32_t page_size = _get_pageSize();
+	uintptr_t offset   = reinterpret_cast<uintptr_t>(begin_ptr) - reinterpret_cast<uintptr_t>(chunk->base_ptr);
+
+	while(0 < byte)
+	{
+		std::size_t page_idx  = offset / page_size;
+		std::size_t page_byte = std::min<std::size_t>(byte, page_size - (offset % page_size));
+
+		chunk->vec_page_carve[page_idx] += page_byte;
+		chunk->vec_page_free[page_idx] = 0;
+
+		offset += page_byte;
+		byte -= page_byte;
+	}
+}
+
+uint64_t memory_pool_c::trim()
+{
+	// remote-freed nodes are reclaimed first. (even if trim is off)
+	std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+	_drain_remote();
+
+	if(MPOOL_TRIM::NONE == _trim_advice) {
+		return 0;
+	}
+
+	uint32_t page_size = _get_pageSize();
+	int advice         = MPOOL_TRIM::FREE == _trim_advice ? MADV_FREE : MADV_DONTNEED;
+
+	// 1. pages without live node. (bump region of current chunk is excluded)
+	std::vector<std::vector<std::uint8_t>> vec_candidate(_vec_chunk.size());
+	std::vector<std::size_t> vec_limit(_vec_chunk.size());
+
+	for(std::size_t chunk_idx = 0; chunk_idx < _vec_chunk.size(); chunk_idx++)
+	{
+		chunk_st& chunk = _vec_chunk[chunk_idx];
+		std::size_t limit_idx = chunk.vec_page_use.size();
+		if(chunk_idx + 1 == _vec_chunk.size()) {
+			limit_idx = (reinterpret_cast<uintptr_t>(_last_ptr) - reinterpret_cast<uintptr_t>(chunk.base_ptr)) / page_size;
+		}
+
+		vec_limit[chunk_idx] = limit_idx;
+		vec_candidate[chunk_idx].assign(chunk.vec_page_use.size(), 0);
+		for(std::size_t page_idx = 0; page_idx < limit_idx; page_idx++) {
+			vec_candidate[chunk_idx][page_idx] = (0 == chunk.vec_page_use[page_idx] && 0 == chunk.vec_page_free[page_idx]);
+		}
+	}
+
+	// 2. free node which touches a candidate page leaves the free-list before madvise overwrites its link.
+	//    (its part in a kept page is not reused until the page is trimmed later)
+	auto page_range = [&](void* node, std::size_t block_size, std::size_t& chunk_idx, std::size_t& first_idx, std::size_t& last_idx) -> bool
+	{
+		chunk_st* chunk = _find_chunk(node);
+		if(nullptr == chunk) {
+			return false;
+		}
+
+		uintptr_t offset = reinterpret_cast<uintptr_t>(node) - reinterpret_cast<uintptr_t>(chunk->base_ptr);
+		chunk_idx = chunk - _vec_chunk.data();
+		first_idx = offset / page_size;
+		last_idx  = (offset + block_size - 1) / page_size;
+		return true;
+	};
+
+	auto is_trimmed = [&](void* node, std::size_t block_size) -> bool
+	{
+		std::size_t chunk_idx, first_idx, last_idx;
+		if(false == page_range(node, block_size, chunk_idx, first_idx, last_idx)) {
+			return false;
+		}
+
+		auto& candidate = vec_candidate[chunk_idx];
+		return std::any_of(candidate.begin() + first_idx, candidate.begin() + last_idx + 1, [](std::uint8_t value) { return 1 == value; });
+	};
+
+	std::vector<std::pair<void*, std::size_t>> vec_detached; // (node, block_size)
+	for(std::size_t class_idx = 0; class_idx < MPOOL_SIZE_CLASS_CNT; class_idx++)
+	{
+		std::size_t block_size = (class_idx + 1) * _get_osBit();
+		mpool_free_list_st kept_list;
+
+		while(nullptr != _free_list[class_idx].head)
+		{
+			void* node = _free_list[class_idx].pop();
+			if(true == is_trimmed(node, block_size))
+			{
+				vec_detached.emplace_back(node, block_size);
+				_free_cnt--;
+			}
+			else {
+				kept_list.push(node);
+			}
+		}
+
+		_free_list[class_idx] = kept_list;
+	}
+
+	for(large_node_st** link = &_large_free_list; nullptr != *link; )
+	{
+		if(true == is_trimmed(*link, (*link)->block_size))
+		{
+			vec_detached.emplace_back(*link, (*link)->block_size);
+			*link = (*link)->next;
+			_free_cnt--;
+		}
+		else {
+			link = &(*link)->next;
+		}
+	}
+
+	// 3. madvise each run of candidate pages.
+	std::uint64_t reclaim_byte = 0;
+	std::vector<unsigned char> vec_resident;
+
+	for(std::size_t chunk_idx = 0; chunk_idx < _vec_chunk.size(); chunk_idx++)
+	{
+		chunk_st& chunk = _vec_chunk[chunk_idx];
+		auto& candidate = vec_candidate[chunk_idx];
+
+		for(std::size_t first_idx = 0; first_idx < candidate.size(); )
+		{
+			if(0 == candidate[first_idx])
+			{
+				first_idx++;
+				continue;
+			}
+
+			std::size_t last_idx = first_idx;
+			while(last_idx < candidate.size() && 1 == candidate[last_idx]) {
+				last_idx++;
+			}
+
+			void* run_ptr        = reinterpret_cast<char*>(chunk.base_ptr) + (first_idx * page_size);
+			std::size_t run_byte = (last_idx - first_idx) * page_size;
+
+			vec_resident.assign(last_idx - first_idx, 0);
+			if(-1 == mincore(run_ptr, run_byte, vec_resident.data())) {
+				vec_resident.assign(last_idx - first_idx, 1);
+			}
+
+			// pages of the failed run are kept as they are. (e.g. EINVAL on mlock-ed pages)
+			if(-1 == madvise(run_ptr, run_byte, advice))
+			{
+				U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "madvise for trim failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+				std::fill(candidate.begin() + first_idx, candidate.begin() + last_idx, 0);
+			}
+			else
+			{
+				for(std::size_t page_idx = first_idx; page_idx < last_idx; page_idx++)
+				{
+					if(0 != (vec_resident[page_idx - first_idx] & 1)) {
+						reclaim_byte += page_size;
+					}
+
+					_mpool_cur_byte.store(_mpool_cur_byte.load(std::memory_order_relaxed) - chunk.vec_page_carve[page_idx], std::memory_order_relaxed);
+					chunk.vec_page_carve[page_idx] = 0;
+					chunk.vec_page_free[page_idx]  = 1;
+				}
+			}
+
+			first_idx = last_idx;
+		}
+	}
+
+	// 4. detached node whose pages are all kept goes back to the free-list.
+	for(auto& [node, block_size] : vec_detached)
+	{
+		if(true == is_trimmed(node, block_size)) {
+			continue;
+		}
+
+		if(std::size_t class_idx = _get_class_idx(block_size); class_idx < MPOOL_SIZE_CLASS_CNT) {
+			_free_list[class_idx].push(node);
+		}
+		else
+		{
+			large_node_st* large_node = reinterpret_cast<large_node_st*>(node);
+			large_node->next          = _large_free_list;
+			large_node->block_size    = block_size;
+			_large_free_list          = large_node;
+		}
+
+		_free_cnt++;
+	}
+
+	// 5. trimmed pages become spans for carving.
+	_vec_span.clear();
+	for(std::size_t chunk_idx = 0; chunk_idx < _vec_chunk.size(); chunk_idx++)
+	{
+		chunk_st& chunk = _vec_chunk[chunk_idx];
+		for(std::size_t first_idx = 0; first_idx < vec_limit[chunk_idx]; )
+		{
+			if(0 == chunk.vec_page_free[first_idx])
+			{
+				first_idx++;
+				continue;
+			}
+
+			std::size_t last_idx = first_idx;
+			while(last_idx < vec_limit[chunk_idx] && 1 == chunk.vec_page_free[last_idx]) {
+				last_idx++;
+			}
+
+			char* base_ptr = reinterpret_cast<char*>(chunk.base_ptr);
+			_vec_span.push_back(span_st{base_ptr + (first_idx * page_size), base_ptr + (last_idx * page_size)});
+
+			first_idx = last_idx;
+		}
+	}
+
+	_trim_byte += reclaim_byte;
+	U_LOG_ROTATE_FILE(util::LOG_LEVEL::INFO, "pool is trimmed. grp_name:{}/reclaim_byte:{}/span_cnt:{}", _grp_name, reclaim_byte, _vec_span.size());
+
+	return reclaim_byte;
+}
+
+void memory_pool_c::_trim_thread_func()
+{
+	std::unique_lock<std::mutex> trim_lock(_trim_lock);
+	while(false == _trim_stop)
+	{
+		if(true == _trim_cv.wait_for(trim_lock, std::chrono::milliseconds(_trim_interval_ms), [this]() { return _trim_stop; })) {
+			break;
+		}
+
+		trim_lock.unlock();
+		trim();
+		trim_lock.lock();
+	}
+}
+
+#ifdef MPOOL_HARDENING
+void memory_pool_c::_poison_node(void* node, std::size_t block_size, bool is_fresh)
+{
+	char* byte_ptr = reinterpret_cast<char*>(node);
+	std::memset(byte_ptr + MPOOL_LINK_BYTE, MPOOL_POISON_BYTE, block_size - MPOOL_LINK_BYTE - sizeof(red_zone_st));
+
+	// freed block keeps owner info for report of use-after-free.
+	if(true == is_fresh)
+	{
+		red_zone_st red_zone{nullptr, 0};
+		std::memcpy(byte_ptr + block_size - sizeof(red_zone_st), &red_zone, sizeof(red_zone_st));
+	}
+}
+
+void memory_pool_c::_verify_node(void* node, std::size_t block_size)
+{
+	const char* byte_ptr = reinterpret_cast<const char*>(node);
+	for(std::size_t offset = MPOOL_LINK_BYTE; offset < block_size - sizeof(red_zone_st); offset++)
+	{
+		if(static_cast<char>(MPOOL_POISON_BYTE) != byte_ptr[offset])
+		{
+			red_zone_st red_zone;
+			std::memcpy(&red_zone, byte_ptr + block_size - sizeof(red_zone_st), sizeof(red_zone_st));
+
+			_report_corrupt("use-after-free", node, block_size, red_zone.type_name, red_zone.obj_size, offset);
+			return;
+		}
+	}
+}
+
+void memory_pool_c::_arm_node(void* node, std::size_t block_size, std::size_t obj_size, const char* type_name)
+{
+	char* byte_ptr = reinterpret_cast<char*>(node);
+	std::memset(byte_ptr + obj_size, MPOOL_CANARY_BYTE, block_size - obj_size - sizeof(red_zone_st));
+
+	red_zone_st red_zone{type_name, obj_size};
+	std::memcpy(byte_ptr + block_size - sizeof(red_zone_st), &red_zone, sizeof(red_zone_st));
+}
+
+void memory_pool_c::_check_red_zone(void* node, std::size_t block_size)
+{
+	const char* byte_ptr = reinterpret_cast<const char*>(node);
+
+	red_zone_st red_zone;
+	std::memcpy(&red_zone, byte_ptr + block_size - sizeof(red_zone_st), sizeof(red_zone_st));
+
+	// owner info itself is overwritten by a long overflow.
+	if(block_size < red_zone.obj_size + MPOOL_RED_ZONE_BYTE)
+	{
+		_report_corrupt("overflow", node, block_size, nullptr, 0, block_size - sizeof(red_zone_st));
+		return;
+	}
+
+	for(std::size_t offset = red_zone.obj_size; offset < block_size - sizeof(red_zone_st); offset++)
+	{
+		if(static_cast<char>(MPOOL_CANARY_BYTE) != byte_ptr[offset])
+		{
+			_report_corrupt("overflow", node, block_size, red_zone.type_name, red_zone.obj_size, offset);
+			return;
+		}
+	}
+}
+
+void memory_pool_c::_report_corrupt(const char* reason, void* node, std::size_t block_size, const char* type_name, std::size_t obj_size, std::size_t offset)
+{
+	_corrupt_cnt.fetch_add(1, std::memory_order_relaxed);
+
+	std::string readable_name = nullptr == type_name ? "unknown" : type_name;
+#if defined(__GNUG__)
+	int status      = 0;
+	char* demangled = abi::__cxa_demangle(readable_name.c_str(), nullptr, nullptr, &status);
+	if(0 == status && nullptr != demangled) {
+		readable_name = demangled;
+	}
+
+	std::free(demangled);
+#endif
+
+	U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "memory corruption({}) in {}. type:{}/obj_size:{}/block_size:{}/offset:{}/node:{:#x}"
+			, reason, _grp_name, readable_name, obj_size, block_size, offset, reinterpret_cast<uintptr_t>(node));
+}
+#endif
+
+memory_pool_c::memory_pool_c(const std::string& grp_name, std::uint32_t use_page_cnt)
+	: memory_pool_c(grp_name, make_page_option(use_page_cnt))
+{
+}
+
+memory_pool_c::memory_pool_c(const std::string& grp_name, const mpool_option_st& option)
+	: _grp_name(grp_name), _use_thread_cache(option.use_thread_cache), _growth(option.growth), _init_page_cnt(option.use_page_cnt), _max_page_cnt(option.max_page_cnt)
+	, _use_huge_page(option.use_huge_page), _use_populate(option.use_populate), _use_prefault(option.use_prefault), _use_mlock(option.use_mlock)
+	, _trim_advice(option.trim_advice), _trim_interval_ms(option.trim_interval_ms), _use_remote_free(option.use_remote_free), _recycle_max_cnt(option.recycle_max_cnt), _pool_id(++g_pool_id_seq)
+{
+	// alignment must be power of two, and not exceed page.
+	std::uint32_t align_byte = option.align_byte;
+	if(0 != align_byte)
+	{
+		if(0 != (align_byte & (align_byte - 1)) || MPOOL_MAX_ALIGN_BYTE < align_byte || _get_pageSize() < align_byte) {
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "align_byte is weird, natural alignment is used. grp_name:{}/align_byte:{}", grp_name, align_byte);
+		}
+		else {
+			_align_byte = std::max<std::uint32_t>(align_byte, _get_osBit());
+		}
+	}
+
+	if(false == _add_chunk(option.use_page_cnt)) {
+		return;
+	}
+
+	_base_ptr        = _last_ptr;
+	_mpool_alloc_cnt = 0;
+	_mpool_cur_byte  = 0;
+
+	if(false == option.vec_warm_up.empty()) {
+		warm_up(option.vec_warm_up);
+	}
+
+	if(MPOOL_TRIM::NONE != _trim_advice && 0 < _trim_interval_ms) {
+		_trim_thread = std::thread(&memory_pool_c::_trim_thread_func, this);
+	}
+}
+
+memory_pool_c::~memory_pool_c()
+{
+	if(true == _trim_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> trim_lock(_trim_lock);
+			_trim_stop = true;
+		}
+
+		_trim_cv.notify_one();
+		_trim_thread.join();
+	}
+
+	// detach thread-caches. (nodes in them are released with mmap region)
+	{
+		std::lock_guard<std::mutex> registry_lock(g_tcache_registry_lock);
+		for(auto tcache : _vec_tcache) {
+			tcache->owner.store(nullptr);
+		}
+
+		_vec_tcache.clear();
+	}
+
+	// recycled nodes still own their members.
+	for(auto& vec_node : _vec_recycle)
+	{
+		for(auto node : vec_node) {
+			node->~base_node_c();
+		}
+	}
+
+	_vec_recycle.clear();
+
+	for(auto& free_list : _free_list) {
+		free_list = mpool_free_list_st();
+	}
+
+	_large_free_list = nullptr;
+	_free_cnt        = 0;
+
+	for(auto& chunk : _vec_chunk)
+	{
+		int result = munmap(chunk.base_ptr, chunk.max_byte);
+		if(-1 == result)
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "munmap failed. grp_name:{}/errno:{}/errstr:{}", _grp_name, errno, strerror(errno));
+		}
+	}
+
+	_vec_chunk.clear();
+	_vec_chunk_index.clear();
+	_vec_span.clear();
 }
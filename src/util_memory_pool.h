@@ -1,26 +1,102 @@
 #ifndef MEMORY_POOL_H
 #define MEMORY_POOL_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
 #include <cstdint>
 #include <mutex>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 #include <sys/mman.h>
 
+/*
+ * -DMPOOL_DEBUG_GRP_NAME : group-name is stored in each node and compared on alloc/free.
+ * otherwise a node is identified by its owner pool pointer, and grp_name argument is only passed to constructor.
+ * it changes the layout of base_node_c, so it must be defined for the library and every client. (CMake option MPOOL_DEBUG_GRP_NAME)
+ */
+
+/*
+ * -DMPOOL_HARDENING : every block ends with a canary red zone and owner info, and freed block is poisoned.
+ * both are verified on free/reuse and broken one is reported with its type and size. (nothing is compiled without it)
+ */
+
 namespace util
 {
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+	// size-class: block byte is (index + 1) * sizeof(void*). bigger block is kept in one large free-list.
+	const std::uint32_t MPOOL_SIZE_CLASS_CNT = 128;
+
+	// thread-cache: when a bin holds MAX_CNT nodes, BATCH_CNT nodes are flushed to the pool at once.
+	const std::uint32_t MPOOL_TCACHE_MAX_CNT   = 64;
+	const std::uint32_t MPOOL_TCACHE_BATCH_CNT = 32;
+
+	// remote-free: block size of a node released by user is tagged with this bit in the remote list. (block size is a multiple of 8)
+	const std::size_t MPOOL_REMOTE_RELEASE_BIT = 1;
+
+	// alignment: MPOOL_CACHE_LINE_BYTE keeps every node on its own cache-lines. (no false-sharing between nodes)
+	const std::uint32_t MPOOL_CACHE_LINE_BYTE = 64;
+	const std::uint32_t MPOOL_MAX_ALIGN_BYTE  = 4096;
+
+#ifdef MPOOL_HARDENING
+	// block layout: [object][canary][owner info(type name, obj size)], freed block keeps link and owner info.
+	const std::uint32_t MPOOL_RED_ZONE_BYTE = 32;
+	const std::uint32_t MPOOL_LINK_BYTE     = 16; // never poisoned. (link of free-list)
+	const std::uint8_t  MPOOL_CANARY_BYTE   = 0xFD;
+	const std::uint8_t  MPOOL_POISON_BYTE   = 0xDD;
+#endif
+
+	// page count of the next chunk when the current chunk is full.
+	enum class MPOOL_GROWTH : std::uint16_t
+	{
+		FIXED = 1, // never grow. (single mmap region)
+		LINEAR,    // same page count as the first chunk.
+		DOUBLE     // twice the page count of the last chunk.
+	};
+
+	// advice for fully-free pages in trim().
+	enum class MPOOL_TRIM : std::uint16_t
+	{
+		NONE = 1, // no page tracking. (trim() only reclaims remote-freed nodes)
+		DONTNEED, // madvise(MADV_DONTNEED), RSS drops immediately.
+		FREE      // madvise(MADV_FREE), kernel reclaims lazily under memory pressure.
+	};
+
 /* ====================================================================== */
 /* ========================== CLASS & STRUCT ============================ */
 /* ====================================================================== */
-	/* if a particular class use this memory-pool, must inherit this class. */
+	class memory_pool_c;
+	struct mpool_tcache_holder_st;
+
+	template <typename T> class pool_ptr;
+	template <typename T> class pool_unique_ptr;
+
+	/*
+	 * if a particular class use this memory-pool, must inherit this class.
+	 * owner pool and reference count are kept in the node itself, so pool_ptr needs no control block.
+	 * owner pointer is also the identity of node. (header is 24 bytes without MPOOL_DEBUG_GRP_NAME)
+	 */
 	class base_node_c
 	{
 	public:
 		friend class memory_pool_c;
+		template <typename T> friend class pool_ptr;
+		template <typename T> friend class pool_unique_ptr;
 
+#ifdef MPOOL_DEBUG_GRP_NAME
 		base_node_c(const std::string& grp_name) : _grp_name(grp_name) {};
+#else
+		base_node_c(const std::string&) {};
+#endif
 		virtual ~base_node_c() = default;
 
 	public:
@@ -31,29 +107,304 @@ namespace util
 		base_node_c& operator=(base_node_c&& rhs)      = delete;
 
 	private:
-		std::string _grp_name;
+		// recycling: recycle_node_c returns the id of its type (-1 is destructed as usual), and is reset only when it is kept.
+		virtual std::int32_t _recycle_id() const { return -1; }
+		virtual void _reset() {}
+
+		std::atomic<std::uint32_t> _ref_cnt{0}; // only used by pool_ptr.
+		std::uint32_t              _block_size = 0;
+		memory_pool_c*             _owner      = nullptr;
+#ifdef MPOOL_DEBUG_GRP_NAME
+		std::string                _grp_name;
+#endif
+	};
+
+	/* id of each recycled type, it is the index of recycle bins in every pool. */
+	inline std::int32_t mpool_next_recycle_id()
+	{
+		static std::atomic<std::int32_t> recycle_id_seq{0};
+		return recycle_id_seq.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	template <typename U>
+	std::int32_t mpool_get_recycle_id()
+	{
+		static const std::int32_t recycle_id = mpool_next_recycle_id();
+		return recycle_id;
+	}
+
+	/*
+	 * node which stays constructed after release, in the pool whose recycle_max_cnt is not 0.
+	 * Derived::reset() is called on release, and Derived::assign(args...) replaces the constructor on reuse.
+	 * so member containers(std::string, std::vector ...) keep their heap capacity across reuse cycles.
+	 */
+	template <typename Derived>
+	class recycle_node_c : public base_node_c
+	{
+	public:
+		using recycle_type = Derived;
+		using base_node_c::base_node_c;
+
+	private:
+		std::int32_t _recycle_id() const override final
+		{
+			// a type derived from Derived has another size and layout, so it must not be reused as Derived.
+			if(typeid(*this) != typeid(Derived)) {
+				return -1;
+			}
+
+			return mpool_get_recycle_id<Derived>();
+		}
+
+		void _reset() override final { static_cast<Derived*>(this)->reset(); }
+	};
+
+	template <typename U, typename = void>
+	struct mpool_is_recycle : std::false_type {};
+
+	template <typename U>
+	struct mpool_is_recycle<U, std::void_t<typename U::recycle_type>> : std::is_same<typename U::recycle_type, U> {};
+
+	/* intrusive free-list. the link is stored in the first bytes of freed node, so push/pop never allocate. */
+	struct mpool_free_list_st
+	{
+		void*         head = nullptr;
+		std::uint32_t cnt  = 0;
+
+		void push(void* node)
+		{
+			*reinterpret_cast<void**>(node) = head;
+			head                            = node;
+			cnt++;
+		}
+
+		void* pop()
+		{
+			void* node = head;
+			if(nullptr != node)
+			{
+				head = *reinterpret_cast<void**>(node);
+				cnt--;
+			}
+
+			return node;
+		}
+	};
+
+	/* counter with one writer at a time(owner thread or _mpool_lock holder), so RMW(lock prefix) is unnecessary. readers never lock. */
+	template <typename T>
+	inline void add_counter(std::atomic<T>& counter, std::common_type_t<T> value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	/* counters of one size-class. (index MPOOL_SIZE_CLASS_CNT is for large blocks) */
+	struct mpool_class_counter_st
+	{
+		std::atomic<std::uint64_t> alloc_cnt{0};
+		std::atomic<std::uint64_t> free_cnt{0};
+		std::atomic<std::uint64_t> bump_cnt{0};       // newly carved nodes.
+		std::atomic<std::uint64_t> out_cnt{0};        // nodes out of the free-list of pool. (live + thread-cached)
+		std::atomic<std::uint64_t> high_water_cnt{0}; // peak of out_cnt.
+	};
+
+	/* statistics of one size-class in mpool_stat_st. */
+	struct mpool_class_stat_st
+	{
+		std::uint64_t block_size     = 0; // 0 is every block bigger than size-classes.
+		std::uint64_t alloc_cnt      = 0;
+		std::uint64_t live_cnt       = 0;
+		std::uint64_t high_water_cnt = 0;
+		std::uint64_t reuse_cnt      = 0; // alloc served by a freed node.
+		std::uint64_t bump_cnt       = 0; // alloc served by a newly carved node.
+	};
+
+	/*
+	 * snapshot of memory_pool_c::get_stat(). every counter is read without _mpool_lock.
+	 * counters are monotonic, so derived values(live/reuse) are clamped when a scrape races with alloc/free.
+	 */
+	struct mpool_stat_st
+	{
+		std::uint64_t alloc_cnt       = 0;
+		std::uint64_t live_cnt        = 0;
+		std::uint64_t reuse_cnt       = 0;
+		std::uint64_t bump_cnt        = 0;
+		std::uint64_t fail_cnt        = 0; // alloc failed by exhausted pool.
+		std::uint64_t lock_cnt        = 0; // _mpool_lock acquisitions in alloc/free path.
+		std::uint64_t contention_cnt  = 0; // acquisitions which had to wait.
+		std::uint64_t cur_byte        = 0;
+		std::uint64_t high_water_byte = 0;
+		std::uint64_t adjust_byte     = 0;
+		std::uint64_t trim_byte       = 0;
+
+		std::vector<mpool_class_stat_st> vec_class_stat; // only size-classes which were used.
+
+		double get_reuse_ratio() const { return 0 == alloc_cnt ? 0.0 : static_cast<double>(reuse_cnt) / alloc_cnt; }
+	};
+
+	/* nodes carved into the free-list before the first alloc. (align_byte 0 is the pool alignment) */
+	struct mpool_reserve_st
+	{
+		std::size_t   obj_size   = 0;
+		std::uint32_t count      = 0;
+		std::size_t   align_byte = 0;
+	};
+
+	/* result of the last warm-up. */
+	struct mpool_warm_up_stat_st
+	{
+		std::uint64_t node_cnt   = 0; // carved nodes. (less than requested when the pool is exhausted)
+		std::uint64_t fault_cnt  = 0; // page-faults taken by touching the nodes.
+		std::uint64_t elapsed_ns = 0;
+	};
+
+	/* optional behaviour of memory_pool_c. */
+	struct mpool_option_st
+	{
+		std::uint32_t use_page_cnt     = 1;
+		bool          use_thread_cache = false; // keep freed nodes in per-thread stacks before returning them to the pool.
+		std::uint32_t align_byte       = 0;     // minimum alignment of every node. (0 is alignof of each type, power of two)
+
+		MPOOL_GROWTH  growth       = MPOOL_GROWTH::FIXED;
+		std::uint32_t max_page_cnt = 0; // hard cap of usable pages over every chunk. (0 is unlimited)
+
+		// mapping of every chunk.
+		bool use_huge_page = false; // madvise(MADV_HUGEPAGE) for transparent huge page.
+		bool use_populate  = false; // mmap with MAP_POPULATE.
+		bool use_prefault  = false; // touch every page right after mmap.
+		bool use_mlock     = false; // mlock usable pages. (limited by RLIMIT_MEMLOCK)
+
+		// returning fully-free pages to OS.
+		MPOOL_TRIM    trim_advice      = MPOOL_TRIM::NONE;
+		std::uint32_t trim_interval_ms = 0; // period of background trim. (0 is manual trim() only)
+
+		// free from a thread other than the owner(first allocating thread) never takes the pool lock.
+		// nodes go onto a lock-free list, and the next alloc which misses the free-list reclaims them in batch.
+		bool use_remote_free = false;
+
+		// constructed nodes kept per recycle_node_c type. (0 disables recycling, over it nodes are destructed as usual)
+		std::uint32_t recycle_max_cnt = 0;
+
+		// warm-up in constructor. every entry is carved into the free-list and its pages are touched.
+		std::vector<mpool_reserve_st> vec_warm_up;
+	};
+
+	/*
+	 * per-thread cache of one memory-pool. (only used inside memory_pool_c)
+	 * the owner thread is the only writer, other threads read counters under registry lock.
+	 * freed node memory is reused as a link, so bins don't need any extra allocation.
+	 */
+	struct mpool_tcache_st
+	{
+		std::atomic<memory_pool_c*> owner{nullptr}; // nullptr after owner pool is destroyed.
+		std::uint64_t               pool_id = 0;
+
+		mpool_free_list_st bins[MPOOL_SIZE_CLASS_CNT];
+
+		std::atomic<std::int64_t> alloc_delta{0}; // alloc_cnt change which is not folded into the pool yet.
+		std::atomic<std::int64_t> cached_cnt{0};
+
+		// per size-class alloc/free served by this cache. (folded into the pool on thread exit)
+		std::atomic<std::uint64_t> class_alloc_cnt[MPOOL_SIZE_CLASS_CNT] = {};
+		std::atomic<std::uint64_t> class_free_cnt[MPOOL_SIZE_CLASS_CNT]  = {};
 	};
 
 	/*
 	 * memory-pool obj can be created anywhere.
 	 * because of using mmap, if there is no more space for virtual memory, some obj are unavailable.
 	 * each node is managed by shared_ptr and release by custom-deleter(memory_pool_c::_free).
+	 * pool_ptr/pool_unique_ptr are cheaper handles. (no control block and no std::bind deleter)
+	 * when thread-cache is enabled, most alloc/free pairs are handled in per-thread stacks without _mpool_lock.
+	 * with growth policy, a new guarded chunk is mapped when the current one is full. (bump-pointer within a chunk)
 	 */
 	class memory_pool_c
 	{
 	public:
+		friend struct mpool_tcache_holder_st;
+		template <typename T> friend class pool_ptr;
+		template <typename T> friend class pool_unique_ptr;
+
+		/*
+		 * constructor arguments are perfectly forwarded, so temporaries are moved into the node and move-only types are allowed.
+		 * emplace() is alloc_unique() with the group-name of this pool.
+		 */
+		template<typename U, typename... Args>
+		std::shared_ptr<U> alloc(const std::string& grp_name, Args&&... args);
+
+		template<typename U, typename... Args>
+		pool_ptr<U> alloc_ptr(const std::string& grp_name, Args&&... args);
+
 		template<typename U, typename... Args>
-		std::shared_ptr<U> alloc(const std::string& grp_name, Args... args);
+		pool_unique_ptr<U> alloc_unique(const std::string& grp_name, Args&&... args);
 
-		uint32_t get_alloc_cnt() const { return _mpool_alloc_cnt; };
+		template<typename U, typename... Args>
+		pool_unique_ptr<U> emplace(Args&&... args);
+
+		/*
+		 * batch alloc/release with one lock. (thread-cache is bypassed)
+		 * gen(idx) returns std::tuple of constructor arguments after grp_name.
+		 * alloc_n is all-or-nothing, empty vector is returned when count nodes can't be reserved.
+		 * when gen or a constructor throws, every node goes back to the pool and the exception is rethrown.
+		 */
+		template<typename U, typename Gen>
+		std::vector<pool_unique_ptr<U>> alloc_n(const std::string& grp_name, std::uint32_t count, Gen&& gen);
+
+		template<typename U>
+		void release_n(std::vector<pool_unique_ptr<U>>& vec_node);
+
+		/*
+		 * raw byte block without base_node_c. (used by mpool_resource_c)
+		 * caller must pass the same byte/align_byte to release_byte(), blocks share size-classes and thread-cache with nodes.
+		 */
+		void* alloc_byte(std::size_t byte, std::size_t align_byte = alignof(std::max_align_t));
+		void release_byte(void* ptr, std::size_t byte, std::size_t align_byte = alignof(std::max_align_t));
+
+		/*
+		 * warm-up : carve count new nodes into the free-list and touch their pages under one lock, so the first allocs
+		 * neither bump nor take a page-fault. reserve<U> returns the carved count, warm_up() is the config-driven form.
+		 * high-water counts are not raised by warm-up.
+		 */
+		template<typename U>
+		std::uint32_t reserve(std::uint32_t count);
+
+		mpool_warm_up_stat_st warm_up(const std::vector<mpool_reserve_st>& vec_reserve);
+		mpool_warm_up_stat_st get_warm_up_stat() const { return _warm_up_stat; };
+
+		uint32_t get_alloc_cnt() const;
+		mpool_stat_st get_stat() const;
 	 	uint32_t get_pool_size(bool need_lock = false);
 
-		uint64_t get_adjust_byte() const { return _mpool_adjust_byte; };
+		uint64_t get_adjust_byte() const { return _mpool_adjust_byte.load(std::memory_order_relaxed); };
+		uint32_t get_align_byte() const { return _align_byte; };
 		uint64_t get_avail_max_byte() const { return _mpool_avail_max_byte; };
-		uint64_t get_cur_byte() const { return _mpool_cur_byte; };
+		uint64_t get_cur_byte() const { return _mpool_cur_byte.load(std::memory_order_relaxed); };
+		uint32_t get_chunk_cnt() const { return _vec_chunk.size(); };
+
+		/* page & fault statistics of mapped chunks. */
+		uint64_t get_mapped_page_cnt() const { return _total_page_cnt; };
+		uint64_t get_resident_page_cnt();
+		uint64_t get_prefault_cnt() const { return _prefault_cnt; };
+		uint32_t get_huge_chunk_cnt() const { return _huge_chunk_cnt; };
+		uint32_t get_locked_chunk_cnt() const { return _locked_chunk_cnt; };
+
+		/*
+		 * trim : madvise pages which hold no live(or thread-cached) node, and return reclaimed resident bytes.
+		 * freed nodes in those pages leave the free-list, and the pages are carved again later.
+		 */
+		uint64_t trim();
+		uint64_t get_trim_byte() const { return _trim_byte; };
+
+		bool is_thread_cache() const { return _use_thread_cache; };
+		bool is_remote_free() const { return _use_remote_free; };
+		std::uint32_t get_recycle_cnt();
+
+#ifdef MPOOL_HARDENING
+		uint64_t get_corrupt_cnt() const { return _corrupt_cnt; };
+#endif
 
 		/* <-- special member functions --> */
 		memory_pool_c(const std::string& grp_name, std::uint32_t use_page_cnt = 1);
+		memory_pool_c(const std::string& grp_name, const mpool_option_st& option);
 		~memory_pool_c();
 
 		memory_pool_c()                                    = delete;
@@ -65,28 +416,314 @@ namespace util
 	private:
 		static std::uint32_t _get_pageSize();
 		static constexpr std::uint32_t _get_osBit() { return sizeof(void*); }
+#ifdef MPOOL_HARDENING
+		static constexpr std::size_t _get_block_size(std::size_t obj_size, std::size_t align_byte = _get_osBit()) { return (obj_size + MPOOL_RED_ZONE_BYTE + align_byte - 1) / align_byte * align_byte; }
+#else
+		static constexpr std::size_t _get_block_size(std::size_t obj_size, std::size_t align_byte = _get_osBit()) { return (obj_size + align_byte - 1) / align_byte * align_byte; }
+#endif
+		static constexpr std::size_t _get_class_idx(std::size_t block_size) { return block_size / _get_osBit() - 1; }
+		static constexpr std::size_t _get_counter_idx(std::size_t block_size) { return std::min<std::size_t>(_get_class_idx(block_size), MPOOL_SIZE_CLASS_CNT); }
+
+		static void _release_tcache(mpool_tcache_st* tcache);
 
 	private:
+		template<typename U>
+		std::size_t _get_align() const { return std::max<std::size_t>(alignof(U), _align_byte); }
+
+		template<typename U, typename... Args>
+		U* _alloc_node(const std::string& grp_name, Args&&... args);
+
 		template<typename U>
 		void _free(U* obj);
 
+		void _release_node(base_node_c* node);
+		bool _recycle_node(base_node_c* node, std::int32_t recycle_id);
+		base_node_c* _reuse_node(std::int32_t recycle_id);
+		base_node_c* _acquire_block(std::size_t obj_size, std::size_t align_byte);
+		void _return_block(void* block, std::size_t block_size);
+
+		std::unique_lock<std::mutex> _lock_pool();
+		void _count_out(std::size_t block_size, std::int64_t delta);
+
+		mpool_tcache_st* _get_tcache();
+		base_node_c* _pop_tcache(mpool_tcache_st* tcache, std::size_t obj_size);
+		void _push_tcache(mpool_tcache_st* tcache, std::size_t block_size, base_node_c* node);
+		void _flush_tcache(mpool_tcache_st* tcache);
+
+		void _trim_thread_func();
+
+		bool _add_chunk(std::uint32_t page_cnt);
+		void _prepare_chunk(void* base_ptr, std::uint64_t avail_byte);
+		bool _grow_chunk(std::size_t block_size);
+		base_node_c* _carve_node(std::size_t obj_size, std::size_t align_byte);
+		base_node_c* _bump_node(void*& cur_ptr, void* end_ptr, std::size_t obj_size, std::size_t align_byte);
+		std::uint32_t _warm_node(std::size_t obj_size, std::size_t align_byte, std::uint32_t count);
+		bool _reserve_run(std::size_t obj_size, std::size_t align_byte, std::uint32_t count, mpool_free_list_st& run);
+		base_node_c* _pop_free(std::size_t block_size, std::size_t align_byte);
+		base_node_c* _pop_free_list(std::size_t block_size, std::size_t align_byte);
+		void _push_free(std::size_t block_size, base_node_c* node);
+
+		struct large_node_st;
+		void _release_run(large_node_st* run, std::uint32_t count);
+		void _push_remote(large_node_st* first, large_node_st* last, std::uint32_t count, std::uint32_t release_cnt);
+		void _drain_remote();
+		bool _is_remote_thread() const;
+
+		struct chunk_st;
+		chunk_st* _find_chunk(void* ptr);
+		void _track_node(void* node, std::size_t block_size, std::int32_t delta);
+		void _track_carve(void* begin_ptr, std::size_t byte);
+
+#ifdef MPOOL_HARDENING
+		struct red_zone_st;
+		void _poison_node(void* node, std::size_t block_size, bool is_fresh);
+		void _verify_node(void* node, std::size_t block_size);
+		void _arm_node(void* node, std::size_t block_size, std::size_t obj_size, const char* type_name);
+		void _check_red_zone(void* node, std::size_t block_size);
+		void _report_corrupt(const char* reason, void* node, std::size_t block_size, const char* type_name, std::size_t obj_size, std::size_t offset);
+#endif
+
+	private:
+		/* freed node whose block is bigger than every size-class. */
+		struct large_node_st
+		{
+			large_node_st* next;
+			std::size_t    block_size;
+		};
+
+		/* each chunk is followed by its own PROT_NONE guard page. */
+		struct chunk_st
+		{
+			void*         base_ptr;
+			std::uint64_t max_byte; // include guard page.
+
+			// per-page state. (only with trim_advice)
+			std::vector<std::uint32_t> vec_page_use;   // nodes which are not in the free-list of pool.
+			std::vector<std::uint32_t> vec_page_carve; // carved byte. (node + padding)
+			std::vector<std::uint8_t>  vec_page_free;  // trimmed, and not carved again.
+		};
+
+#ifdef MPOOL_HARDENING
+		/* owner info at the end of block. */
+		struct red_zone_st
+		{
+			const char*   type_name;
+			std::uint64_t obj_size;
+		};
+#endif
+
+		/* trimmed pages which are carved before current chunk. */
+		struct span_st
+		{
+			void* cur_ptr;
+			void* end_ptr;
+		};
+
 	private:
-		std::string _grp_name;
-		std::unordered_multimap<size_t, base_node_c*> _mpool;
+		std::string        _grp_name;
+		mpool_free_list_st _free_list[MPOOL_SIZE_CLASS_CNT];
+		large_node_st*     _large_free_list = nullptr;
+		std::uint32_t      _free_cnt        = 0;
 
-		bool _check_mprotect = true;
+		bool _check_mprotect   = true;
+		bool _use_thread_cache = false;
+
+		std::uint32_t _align_byte = _get_osBit(); // every block address is a multiple of this.
 
 		void* _last_ptr = nullptr;
 		void* _base_ptr = nullptr;
+		void* _end_ptr  = nullptr; // end of current chunk.
+
+		std::vector<chunk_st> _vec_chunk;
+		std::vector<std::pair<uintptr_t, std::uint32_t>> _vec_chunk_index; // (base address, index of _vec_chunk) sorted by address.
+		MPOOL_GROWTH          _growth              = MPOOL_GROWTH::FIXED;
+		std::uint32_t         _init_page_cnt       = 0;
+		std::uint32_t         _last_chunk_page_cnt = 0;
+		std::uint32_t         _total_page_cnt      = 0;
+		std::uint32_t         _max_page_cnt        = 0;
+
+		bool          _use_huge_page    = false;
+		bool          _use_populate     = false;
+		bool          _use_prefault     = false;
+		bool          _use_mlock        = false;
+		std::uint64_t _prefault_cnt     = 0;
+		std::uint32_t _huge_chunk_cnt   = 0;
+		std::uint32_t _locked_chunk_cnt = 0;
+
+		MPOOL_TRIM              _trim_advice      = MPOOL_TRIM::NONE;
+		std::uint32_t           _trim_interval_ms = 0;
+		std::atomic<uint64_t>   _trim_byte{0};
+		std::vector<span_st>    _vec_span;
+		bool                    _trim_stop        = false;
+		std::thread             _trim_thread;
+		std::mutex              _trim_lock;
+		std::condition_variable _trim_cv;
+
+		bool                         _use_remote_free = false;
+		std::atomic<large_node_st*>  _remote_head{nullptr};
+		std::atomic<std::int64_t>    _remote_cnt{0};         // every node in the remote list.
+		std::atomic<std::int64_t>    _remote_release_cnt{0}; // nodes released by user, not folded into alloc_cnt yet.
+		std::atomic<std::thread::id> _remote_owner{};        // first thread which pops the free-list. its frees take the direct path.
+
+		std::atomic<std::int64_t>  _mpool_alloc_cnt{0};
+		std::uint64_t              _mpool_max_byte       = 0;
+		std::uint64_t              _mpool_avail_max_byte = 0;
+		std::atomic<std::uint64_t> _mpool_cur_byte{0};
+		std::atomic<std::uint64_t> _mpool_high_water_byte{0};
+		std::atomic<std::uint64_t> _mpool_adjust_byte{0};
+
+		mpool_class_counter_st     _class_counter[MPOOL_SIZE_CLASS_CNT + 1];
+		std::atomic<std::uint64_t> _fail_cnt{0};
+		std::atomic<std::uint64_t> _lock_cnt{0};
+		std::atomic<std::uint64_t> _contention_cnt{0};
+#ifdef MPOOL_HARDENING
+		std::atomic<std::uint64_t> _corrupt_cnt{0};
+#endif
 
-		std::int32_t _mpool_alloc_cnt       = 0;
-		std::uint64_t _mpool_max_byte       = 0;
-		std::uint64_t _mpool_avail_max_byte = 0;
-		std::uint64_t _mpool_cur_byte       = 0;
-		std::uint64_t _mpool_adjust_byte    = 0;
+		mpool_warm_up_stat_st _warm_up_stat;
+
+		std::uint32_t                          _recycle_max_cnt = 0;
+		std::vector<std::vector<base_node_c*>> _vec_recycle; // recycle id -> constructed nodes. (guarded by _mpool_lock)
+
+		std::uint64_t                 _pool_id = 0;
+		std::vector<mpool_tcache_st*> _vec_tcache; // guarded by registry lock.
 
 		std::mutex _mpool_lock;
 	};
+
+	/*
+	 * intrusive shared handle of pool node. (reference count is in base_node_c)
+	 * when the last handle is released, the node returns to its owner pool.
+	 */
+	template <typename T>
+	class pool_ptr
+	{
+	public:
+		template <typename Y> friend class pool_ptr;
+
+		T* get() const { return _node; }
+		T& operator*() const { return *_node; }
+		T* operator->() const { return _node; }
+		explicit operator bool() const { return nullptr != _node; }
+
+		std::uint32_t use_count() const { return nullptr == _node ? 0 : _base()->_ref_cnt.load(std::memory_order_relaxed); }
+
+		void reset()
+		{
+			if(nullptr == _node) {
+				return;
+			}
+
+			base_node_c* base_node = _base();
+			_node                  = nullptr;
+
+			if(1 == base_node->_ref_cnt.fetch_sub(1, std::memory_order_acq_rel)) {
+				base_node->_owner->_release_node(base_node);
+			}
+		}
+
+		/* <-- special member functions --> */
+		pool_ptr() = default;
+		pool_ptr(std::nullptr_t) {}
+		explicit pool_ptr(T* node) : _node(node) { _add_ref(); }
+		~pool_ptr() { reset(); }
+
+		pool_ptr(const pool_ptr& rhs) : _node(rhs._node) { _add_ref(); }
+		pool_ptr(pool_ptr&& rhs) noexcept : _node(rhs._node) { rhs._node = nullptr; }
+
+		template <typename Y, typename = std::enable_if_t<std::is_convertible<Y*, T*>::value>>
+		pool_ptr(const pool_ptr<Y>& rhs) : _node(rhs._node) { _add_ref(); }
+
+		template <typename Y, typename = std::enable_if_t<std::is_convertible<Y*, T*>::value>>
+		pool_ptr(pool_ptr<Y>&& rhs) noexcept : _node(rhs._node) { rhs._node = nullptr; }
+
+		template <typename Y, typename = std::enable_if_t<std::is_convertible<Y*, T*>::value>>
+		pool_ptr(pool_unique_ptr<Y>&& rhs) : _node(rhs.release()) { _add_ref(); }
+
+		pool_ptr& operator=(const pool_ptr& rhs)
+		{
+			pool_ptr(rhs).swap(*this);
+			return *this;
+		}
+
+		pool_ptr& operator=(pool_ptr&& rhs) noexcept
+		{
+			pool_ptr(std::move(rhs)).swap(*this);
+			return *this;
+		}
+
+		void swap(pool_ptr& rhs) noexcept { std::swap(_node, rhs._node); }
+
+	private:
+		base_node_c* _base() const { return static_cast<base_node_c*>(_node); }
+
+		void _add_ref()
+		{
+			if(nullptr != _node) {
+				_base()->_ref_cnt.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		T* _node = nullptr;
+	};
+
+	/* unique handle of pool node. no atomic operation at all. */
+	template <typename T>
+	class pool_unique_ptr
+	{
+	public:
+		T* get() const { return _node; }
+		T& operator*() const { return *_node; }
+		T* operator->() const { return _node; }
+		explicit operator bool() const { return nullptr != _node; }
+
+		T* release()
+		{
+			T* node = _node;
+			_node   = nullptr;
+
+			return node;
+		}
+
+		void reset()
+		{
+			if(nullptr == _node) {
+				return;
+			}
+
+			base_node_c* base_node = static_cast<base_node_c*>(release());
+			base_node->_owner->_release_node(base_node);
+		}
+
+		/* <-- special member functions --> */
+		pool_unique_ptr() = default;
+		pool_unique_ptr(std::nullptr_t) {}
+		explicit pool_unique_ptr(T* node) : _node(node) {}
+		~pool_unique_ptr() { reset(); }
+
+		pool_unique_ptr(pool_unique_ptr&& rhs) noexcept : _node(rhs.release()) {}
+
+		template <typename Y, typename = std::enable_if_t<std::is_convertible<Y*, T*>::value>>
+		pool_unique_ptr(pool_unique_ptr<Y>&& rhs) : _node(rhs.release()) {}
+
+		pool_unique_ptr& operator=(pool_unique_ptr&& rhs) noexcept
+		{
+			if(this != &rhs)
+			{
+				reset();
+				_node = rhs.release();
+			}
+
+			return *this;
+		}
+
+		pool_unique_ptr(const pool_unique_ptr& rhs)            = delete;
+		pool_unique_ptr& operator=(const pool_unique_ptr& rhs) = delete;
+
+	private:
+		T* _node = nullptr;
+	};
 }
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef MEMORY_POOL_HPP
 #define MEMORY_POOL_HPP
 #include <functional>
+#include <tuple>
 
 #include "util_logger.h"
 #include "util_memory_pool.h"
@@ -15,92 +16,266 @@ void memory_pool_c::_free(U* obj)
 {
 	static_assert(std::is_base_of<base_node_c, U>::value, "U must inherit from base_node_c");
 
-	base_node_c* base_obj = static_cast<base_node_c*>(obj);
-	if(0 != base_obj->_grp_name.compare(_grp_name))
+	_release_node(static_cast<base_node_c*>(obj));
+}
+
+template <typename U, typename... Args>
+U* memory_pool_c::_alloc_node(const std::string& grp_name, Args&&... args)
+{
+	// check inheritance
+	static_assert(std::is_base_of<base_node_c, U>::value, "U must be derived from base_node_c");
+
+#ifdef MPOOL_DEBUG_GRP_NAME
+	if(0 != _grp_name.compare(grp_name))
 	{
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "grp_name is weird. pivot-grp_name:{}/param-grp_name:{}", _grp_name, base_obj->_grp_name);
-		return;
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "grp_name is weird. pivot-grp_name:{}/param-grp_name:{}", _grp_name, grp_name);
+		return nullptr;
 	}
+#endif
 
-	// call destructor
-	obj->~U();
+	static_assert(alignof(U) <= MPOOL_MAX_ALIGN_BYTE, "alignof(U) must not exceed MPOOL_MAX_ALIGN_BYTE");
 
-	std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+	size_t align_byte = _get_align<U>();
+	size_t block_size = _get_block_size(sizeof(U), align_byte);
 
-	size_t obj_size = sizeof(U);
-	_mpool.insert(std::make_pair(obj_size, base_obj));
+	// constructed node of U is reused by assign().
+	if constexpr(true == mpool_is_recycle<U>::value)
+	{
+		if(0 < _recycle_max_cnt)
+		{
+			if(base_node_c* base_node = _reuse_node(mpool_get_recycle_id<U>()); nullptr != base_node)
+			{
+				U* node = static_cast<U*>(base_node);
+				try {
+					node->assign(std::forward<Args>(args)...);
+				}
+				catch(...)
+				{
+					node->~U();
+					_return_block(base_node, block_size);
+					throw;
+				}
+
+				return node;
+			}
+		}
+	}
+
+	base_node_c* base_node = _acquire_block(sizeof(U), align_byte);
+	if(nullptr == base_node) {
+		return nullptr;
+	}
 
-	_mpool_alloc_cnt--;
-	if (_mpool_alloc_cnt < 0) {
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "_mpool_alloc_cnt is negative number. grp_name:{}/alloc_cnt:{}", _grp_name, _mpool_alloc_cnt);
+	// call placement new. (block goes back when the constructor throws)
+	U* node = nullptr;
+	try {
+		node = new(base_node) U(grp_name, std::forward<Args>(args)...);
+	}
+	catch(...)
+	{
+#ifdef MPOOL_HARDENING
+		_arm_node(base_node, block_size, sizeof(U), typeid(U).name());
+#endif
+		_return_block(base_node, block_size);
+		throw;
 	}
+
+	base_node              = static_cast<base_node_c*>(node);
+	base_node->_owner      = this;
+	base_node->_block_size = block_size;
+
+#ifdef MPOOL_HARDENING
+	_arm_node(base_node, block_size, sizeof(U), typeid(U).name());
+#endif
+
+	return node;
+}
+
+template <typename U, typename... Args>
+std::shared_ptr<U> memory_pool_c::alloc(const std::string& grp_name, Args&&... args)
+{
+	U* node = _alloc_node<U>(grp_name, std::forward<Args>(args)...);
+	if(nullptr == node) {
+		return nullptr;
+	}
+
+	std::shared_ptr<U> wrapped_node(node, std::bind(&memory_pool_c::_free<U>, this, std::placeholders::_1));
+	return wrapped_node;
+}
+
+template <typename U, typename... Args>
+pool_ptr<U> memory_pool_c::alloc_ptr(const std::string& grp_name, Args&&... args)
+{
+	return pool_ptr<U>(_alloc_node<U>(grp_name, std::forward<Args>(args)...));
+}
+
+template <typename U, typename... Args>
+pool_unique_ptr<U> memory_pool_c::alloc_unique(const std::string& grp_name, Args&&... args)
+{
+	return pool_unique_ptr<U>(_alloc_node<U>(grp_name, std::forward<Args>(args)...));
 }
 
 template <typename U, typename... Args>
-std::shared_ptr<U> memory_pool_c::alloc(const std::string& grp_name, Args... args)
+pool_unique_ptr<U> memory_pool_c::emplace(Args&&... args)
+{
+	return pool_unique_ptr<U>(_alloc_node<U>(_grp_name, std::forward<Args>(args)...));
+}
+
+template <typename U, typename Gen>
+std::vector<pool_unique_ptr<U>> memory_pool_c::alloc_n(const std::string& grp_name, std::uint32_t count, Gen&& gen)
 {
 	// check inheritance
 	static_assert(std::is_base_of<base_node_c, U>::value, "U must be derived from base_node_c");
+	static_assert(alignof(U) <= MPOOL_MAX_ALIGN_BYTE, "alignof(U) must not exceed MPOOL_MAX_ALIGN_BYTE");
 
+	std::vector<pool_unique_ptr<U>> vec_node;
+#ifdef MPOOL_DEBUG_GRP_NAME
 	if(0 != _grp_name.compare(grp_name))
 	{
 		U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "grp_name is weird. pivot-grp_name:{}/param-grp_name:{}", _grp_name, grp_name);
-		return nullptr;
+		return vec_node;
 	}
+#endif
 
 	if(nullptr == _base_ptr || false == _check_mprotect)
 	{
 		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "base_ptr is nullptr. OR check_mprotect is false. grp_name:{}/base_ptr:{}/check_mprotect:{}"
 				, _grp_name, _base_ptr == nullptr ? "T" : "F", _check_mprotect == true ? "T" : "F");
-		return nullptr;
+		return vec_node;
 	}
 
-	base_node_c* base_node = nullptr;
-	size_t obj_size = sizeof(U);
+	// reserve every node at once. (linked by intrusive list)
+	size_t align_byte = _get_align<U>();
+	size_t block_size = _get_block_size(sizeof(U), align_byte);
 
-	if(_mpool_avail_max_byte < _mpool_cur_byte + obj_size)
+	mpool_free_list_st run;
 	{
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "can't alloc memory in {}. max_byte:{}/cur_alloc_byte:{}/req_byte:{}", _grp_name, _mpool_avail_max_byte, _mpool_cur_byte, obj_size);
-		return nullptr;
+		std::unique_lock<std::mutex> pool_lock = _lock_pool();
+		if(false == _reserve_run(sizeof(U), align_byte, count, run)) {
+			return vec_node;
+		}
 	}
 
-	// alloc node
+	// call placement new
+	vec_node.reserve(count);
+
+	void* raw_node = nullptr;
+	try
 	{
-		std::lock_guard<std::mutex> pool_lock(_mpool_lock);
+		for(std::uint32_t idx = 0; idx < count; idx++)
+		{
+			raw_node = run.pop();
+#ifdef MPOOL_HARDENING
+			_verify_node(raw_node, block_size);
+#endif
 
-		auto find_iter = _mpool.find(obj_size);
-		if(_mpool.end() == find_iter)
+			U* node = std::apply([&grp_name, raw_node](auto&&... args) {
+					return new(raw_node) U(grp_name, std::forward<decltype(args)>(args)...);
+				}, gen(idx));
+
+			raw_node = nullptr;
+
+			base_node_c* base_node = static_cast<base_node_c*>(node);
+			base_node->_owner      = this;
+			base_node->_block_size = block_size;
+
+#ifdef MPOOL_HARDENING
+			_arm_node(base_node, block_size, sizeof(U), typeid(U).name());
+#endif
+
+			vec_node.emplace_back(node);
+		}
+	}
+	catch(...)
+	{
+		// nodes which were never constructed go back to the free-list, and vec_node releases constructed ones.
+		if(nullptr != raw_node)
 		{
-			uint32_t adjust_size            = 0;
-			base_node                       = reinterpret_cast<base_node_c*>(_last_ptr);
-			constexpr std::uint32_t os_byte = _get_osBit();
+#ifdef MPOOL_HARDENING
+			_poison_node(raw_node, block_size, false);
+#endif
+			run.push(raw_node);
+		}
 
-			if(obj_size % os_byte != 0)
-			{
-				std::uint32_t quotient = obj_size / os_byte;
-				adjust_size            = (quotient + 1) * os_byte;
+		{
+			std::unique_lock<std::mutex> pool_lock = _lock_pool();
 
-				_mpool_adjust_byte += (adjust_size - obj_size);
+			std::int64_t unused_cnt = run.cnt;
+			while(nullptr != run.head) {
+				_push_free(block_size, reinterpret_cast<base_node_c*>(run.pop()));
 			}
 
-			// calc position
-			_last_ptr = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(_last_ptr) + obj_size + adjust_size);
-			_mpool_cur_byte += (obj_size + adjust_size);
+			add_counter(_mpool_alloc_cnt, -unused_cnt);
+			add_counter(_class_counter[_get_counter_idx(block_size)].alloc_cnt, -unused_cnt);
 		}
-		else
+
+		vec_node.clear();
+		throw;
+	}
+
+	return vec_node;
+}
+
+template <typename U>
+std::uint32_t memory_pool_c::reserve(std::uint32_t count)
+{
+	static_assert(std::is_base_of<base_node_c, U>::value, "U must be derived from base_node_c");
+
+	mpool_warm_up_stat_st warm_up_stat = warm_up({mpool_reserve_st{sizeof(U), count, _get_align<U>()}});
+	return static_cast<std::uint32_t>(warm_up_stat.node_cnt);
+}
+
+template <typename U>
+void memory_pool_c::release_n(std::vector<pool_unique_ptr<U>>& vec_node)
+{
+	// call destructor of every node, and link them with their block size.
+	large_node_st* run = nullptr;
+	std::uint32_t count = 0;
+
+	for(auto& handle : vec_node)
+	{
+		base_node_c* base_node = static_cast<base_node_c*>(handle.get());
+		if(nullptr == base_node) {
+			continue;
+		}
+
+		// rejected handle is left alone, and vec_node.clear() returns it to its own owner.
+		if(this != base_node->_owner)
 		{
-			base_node = find_iter->second;
-			_mpool.erase(find_iter);
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "node is not owned by this pool. grp_name:{}", _grp_name);
+			continue;
 		}
 
-		_mpool_alloc_cnt++;
-	}
+#ifdef MPOOL_DEBUG_GRP_NAME
+		if(0 != base_node->_grp_name.compare(_grp_name))
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "grp_name is weird. pivot-grp_name:{}/param-grp_name:{}", _grp_name, base_node->_grp_name);
+			continue;
+		}
+#endif
 
-	// call placement new
-	base_node = new(base_node) U(grp_name, args...);
+		handle.release();
 
-	std::shared_ptr<U> wrapped_node(static_cast<U*>(base_node), std::bind(&memory_pool_c::_free<U>, this, std::placeholders::_1));
-	return wrapped_node;
+		std::size_t block_size = base_node->_block_size;
+#ifdef MPOOL_HARDENING
+		_check_red_zone(base_node, block_size);
+#endif
+
+		base_node->~base_node_c();
+#ifdef MPOOL_HARDENING
+		_poison_node(base_node, block_size, false);
+#endif
+
+		large_node_st* dead_node = reinterpret_cast<large_node_st*>(base_node);
+		dead_node->next          = run;
+		dead_node->block_size    = block_size;
+
+		run = dead_node;
+		count++;
+	}
+
+	vec_node.clear();
+	_release_run(run, count);
 }
 
 #endif
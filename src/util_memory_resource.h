@@ -0,0 +1,62 @@
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include "util_memory_pool.h"
+
+namespace util
+{
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+	/*
+	 * std::pmr::memory_resource over memory_pool_c. variable-sized requests are recycled by size-class of the pool.
+	 * containers inside pooled objects(std::pmr::string, std::pmr::vector ...) allocate from the same mmap region.
+	 * std::bad_alloc is thrown when the pool is exhausted, as memory_resource requires.
+	 */
+	class mpool_resource_c : public std::pmr::memory_resource
+	{
+	public:
+		memory_pool_c& get_pool() const { return _mpool; }
+
+		/* <-- special member functions --> */
+		explicit mpool_resource_c(memory_pool_c& mpool) : _mpool(mpool) {}
+		~mpool_resource_c() override = default;
+
+		mpool_resource_c()                                       = delete;
+		mpool_resource_c(const mpool_resource_c& rhs)            = delete;
+		mpool_resource_c& operator=(const mpool_resource_c& rhs) = delete;
+		mpool_resource_c(mpool_resource_c&& rhs)                 = delete;
+		mpool_resource_c& operator=(mpool_resource_c&& rhs)      = delete;
+
+	private:
+		void* do_allocate(std::size_t byte, std::size_t align_byte) override
+		{
+			void* ptr = _mpool.alloc_byte(byte, align_byte);
+			if(nullptr == ptr) {
+				throw std::bad_alloc();
+			}
+
+			return ptr;
+		}
+
+		void do_deallocate(void* ptr, std::size_t byte, std::size_t align_byte) override
+		{
+			_mpool.release_byte(ptr, byte, align_byte);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+		{
+			const mpool_resource_c* other = dynamic_cast<const mpool_resource_c*>(&rhs);
+			return nullptr != other && &_mpool == &other->_mpool;
+		}
+
+	private:
+		memory_pool_c& _mpool;
+	};
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+	// every block starts on its own cache-line.
+	const std::uint32_t OPOOL_CACHE_LINE_BYTE = 64;
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+	/*
+	 * typed pool for homogeneous objects. slot size and alignment are fixed at compile time,
+	 * T needs no base class, and no group-name is checked. (not thread-safe: one pool per thread or external lock)
+	 * a block holds BlockSize contiguous slots. freed slots are reused in LIFO order, so hot slots stay in cache.
+	 */
+	template <typename T, std::size_t BlockSize = 256>
+	class object_pool_c
+	{
+	private:
+		/* freed slot keeps the link in its own storage. */
+		union slot_u
+		{
+			slot_u* next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+	public:
+		static constexpr std::size_t SLOT_SIZE   = sizeof(slot_u);
+		static constexpr std::size_t SLOT_ALIGN  = alignof(slot_u);
+		static constexpr std::size_t BLOCK_ALIGN = std::max<std::size_t>(SLOT_ALIGN, OPOOL_CACHE_LINE_BYTE);
+		static constexpr std::size_t BLOCK_BYTE  = SLOT_SIZE * BlockSize;
+
+		static_assert(0 < BlockSize, "BlockSize must be greater than 0");
+		static_assert(false == std::is_abstract_v<T>, "T must be a concrete type");
+
+		/* unique_ptr which returns the object to its pool. */
+		struct deleter_st
+		{
+			object_pool_c* pool = nullptr;
+			void operator()(T* obj) const { pool->release(obj); }
+		};
+
+		using unique_ptr = std::unique_ptr<T, deleter_st>;
+
+		/* <-- special member functions --> */
+		object_pool_c() = default;
+		~object_pool_c();
+
+		object_pool_c(const object_pool_c& rhs)            = delete;
+		object_pool_c& operator=(const object_pool_c& rhs) = delete;
+		object_pool_c(object_pool_c&& rhs)                 = delete;
+		object_pool_c& operator=(object_pool_c&& rhs)      = delete;
+
+		// return nullptr when a new block can't be allocated.
+		template <typename... Args>
+		T* alloc(Args&&... args);
+
+		template <typename... Args>
+		unique_ptr alloc_unique(Args&&... args) { return unique_ptr(alloc(std::forward<Args>(args)...), deleter_st{this}); }
+
+		void release(T* obj);
+
+		// reserve blocks for obj_cnt objects in advance.
+		bool reserve(std::size_t obj_cnt);
+
+		std::size_t get_alloc_cnt() const { return _alloc_cnt; };
+		std::size_t get_free_cnt() const { return _free_cnt; };
+		std::size_t get_block_cnt() const { return _vec_block.size(); };
+		std::size_t get_capacity() const { return _vec_block.size() * BlockSize; };
+
+	private:
+		bool _add_block();
+
+		slot_u*              _free_head = nullptr;
+		slot_u*              _last_ptr  = nullptr; // bump pointer in the newest block.
+		slot_u*              _end_ptr   = nullptr;
+		std::size_t          _alloc_cnt = 0;
+		std::size_t          _free_cnt  = 0;
+		std::vector<slot_u*> _vec_block;
+	};
+
+	template <typename T, std::size_t BlockSize>
+	object_pool_c<T, BlockSize>::~object_pool_c()
+	{
+		// live objects are not destructed. (same as memory_pool_c)
+		for(auto block : _vec_block) {
+			::operator delete(block, std::align_val_t(BLOCK_ALIGN));
+		}
+	}
+
+	template <typename T, std::size_t BlockSize>
+	template <typename... Args>
+	T* object_pool_c<T, BlockSize>::alloc(Args&&... args)
+	{
+		slot_u* slot = _free_head;
+		if(nullptr != slot)
+		{
+			_free_head = slot->next;
+			_free_cnt--;
+		}
+		else
+		{
+			if(_last_ptr == _end_ptr && false == _add_block()) {
+				return nullptr;
+			}
+
+			slot = _last_ptr++;
+		}
+
+		T* obj = nullptr;
+		try {
+			obj = ::new(static_cast<void*>(slot->storage)) T(std::forward<Args>(args)...);
+		}
+		catch(...)
+		{
+			slot->next = _free_head;
+			_free_head = slot;
+			_free_cnt++;
+			throw;
+		}
+
+		_alloc_cnt++;
+		return obj;
+	}
+
+	template <typename T, std::size_t BlockSize>
+	void object_pool_c<T, BlockSize>::release(T* obj)
+	{
+		if(nullptr == obj) {
+			return;
+		}
+
+		obj->~T();
+
+		slot_u* slot = reinterpret_cast<slot_u*>(obj);
+		slot->next   = _free_head;
+		_free_head   = slot;
+
+		_free_cnt++;
+		_alloc_cnt--;
+	}
+
+	template <typename T, std::size_t BlockSize>
+	bool object_pool_c<T, BlockSize>::reserve(std::size_t obj_cnt)
+	{
+		std::size_t remain_cnt = _free_cnt + static_cast<std::size_t>(_end_ptr - _last_ptr);
+		while(remain_cnt < obj_cnt)
+		{
+			// the rest of current block goes to the free-list, so a new block doesn't waste it.
+			for(; _last_ptr != _end_ptr; _last_ptr++)
+			{
+				_last_ptr->next = _free_head;
+				_free_head      = _last_ptr;
+				_free_cnt++;
+			}
+
+			if(false == _add_block()) {
+				return false;
+			}
+
+			remain_cnt += BlockSize;
+		}
+
+		return true;
+	}
+
+	template <typename T, std::size_t BlockSize>
+	bool object_pool_c<T, BlockSize>::_add_block()
+	{
+		void* block = ::operator new(BLOCK_BYTE, std::align_val_t(BLOCK_ALIGN), std::nothrow);
+		if(nullptr == block) {
+			return false;
+		}
+
+		// block goes back when its slot in _vec_block can't be allocated.
+		try {
+			_vec_block.push_back(static_cast<slot_u*>(block));
+		}
+		catch(const std::bad_alloc&)
+		{
+			::operator delete(block, std::align_val_t(BLOCK_ALIGN));
+			return false;
+		}
+
+		_last_ptr = static_cast<slot_u*>(block);
+		_end_ptr  = _last_ptr + BlockSize;
+		return true;
+	}
+}
+
+#endif
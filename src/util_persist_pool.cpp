@@ -0,0 +1,251 @@
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "util_logger.h"
+#include "util_persist_pool.h"
+
+using namespace util;
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+bool persist_pool_c::sync()
+{
+	if(nullptr == _base_ptr) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+	if(-1 == msync(_base_ptr, _file_byte, MS_SYNC))
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "msync failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+bool persist_pool_c::_open(std::uint64_t file_byte)
+{
+	_fd = open(_file_path.c_str(), O_RDWR | O_CREAT, 0644);
+	if(-1 == _fd)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "open failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		return false;
+	}
+
+	// only one pool maps the file. (released by close, also when the process is killed)
+	if(-1 == flock(_fd, LOCK_EX | LOCK_NB))
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "file is locked by another pool. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		return false;
+	}
+
+	struct stat file_stat{};
+	if(-1 == fstat(_fd, &file_stat))
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "fstat failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		return false;
+	}
+
+	// existing file keeps its own size.
+	_is_attached = 0 < file_stat.st_size;
+	if(true == _is_attached)
+	{
+		if(static_cast<std::uint64_t>(file_stat.st_size) < sizeof(ppool_file_header_st))
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "file is too small. grp_name:{}/file_path:{}/file_byte:{}", _grp_name, _file_path, file_stat.st_size);
+			return false;
+		}
+
+		_file_byte = static_cast<std::uint64_t>(file_stat.st_size);
+	}
+	else
+	{
+		std::uint64_t page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+		_file_byte              = (std::max<std::uint64_t>(file_byte, page_size * 2) + page_size - 1) / page_size * page_size;
+
+		if(-1 == ftruncate(_fd, static_cast<off_t>(_file_byte)))
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "ftruncate failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+			return false;
+		}
+	}
+
+	void* base_ptr = mmap(nullptr, _file_byte, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if(MAP_FAILED == base_ptr)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "mmap failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		return false;
+	}
+
+	_base_ptr = reinterpret_cast<char*>(base_ptr);
+	_header   = reinterpret_cast<ppool_file_header_st*>(_base_ptr);
+
+	bool result = true == _is_attached ? _attach() : _format();
+	if(false == result)
+	{
+		munmap(_base_ptr, _file_byte);
+		_base_ptr = nullptr;
+		_header   = nullptr;
+	}
+
+	return result;
+}
+
+bool persist_pool_c::_format()
+{
+	std::uint64_t page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+
+	_header->version     = PPOOL_VERSION;
+	_header->is_clean    = 0;
+	_header->file_byte   = _file_byte;
+	_header->data_offset = page_size;
+	_header->bump_offset = page_size;
+	_header->root_offset = 0;
+
+	// magic is written last, a half-formatted file is never attached.
+	_header->magic = PPOOL_MAGIC;
+
+	_is_clean_close = true;
+	return true;
+}
+
+bool persist_pool_c::_attach()
+{
+	// killed before the first format was done.
+	if(0 == _header->magic)
+	{
+		_is_attached = false;
+		return _format();
+	}
+
+	if(PPOOL_MAGIC != _header->magic || PPOOL_VERSION != _header->version)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "file is not a persist pool. grp_name:{}/file_path:{}/magic:{:#x}/version:{}", _grp_name, _file_path, _header->magic, _header->version);
+		return false;
+	}
+
+	if(_file_byte != _header->file_byte || _header->data_offset < sizeof(ppool_file_header_st) || _file_byte < _header->bump_offset || _header->bump_offset < _header->data_offset)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "file header is weird. grp_name:{}/file_path:{}/file_byte:{}/bump_offset:{}", _grp_name, _file_path, _header->file_byte, _header->bump_offset);
+		return false;
+	}
+
+	_is_clean_close = 1 == _header->is_clean;
+	_header->is_clean = 0;
+
+	_rebuild();
+	return true;
+}
+
+void persist_pool_c::_rebuild()
+{
+	// free-lists and counts are rebuilt from records. a torn record at the tail (killed while carving) is cut off.
+	for(std::uint64_t offset = _header->data_offset; offset < _header->bump_offset;)
+	{
+		ppool_record_st* record = reinterpret_cast<ppool_record_st*>(_base_ptr + offset);
+
+		std::uint64_t block_size = record->block_size;
+		if(block_size <= sizeof(ppool_record_st) || 0 != block_size % PPOOL_ALIGN_BYTE || _header->bump_offset - offset < block_size)
+		{
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "broken record is cut off. grp_name:{}/file_path:{}/offset:{}/block_size:{}", _grp_name, _file_path, offset, block_size);
+			_header->bump_offset = offset;
+			break;
+		}
+
+		if(PPOOL_RECORD_LIVE == record->state) {
+			_live_cnt++;
+		}
+		else {
+			_free_record(record);
+		}
+
+		offset += block_size;
+	}
+
+	if(0 != _header->root_offset)
+	{
+		std::uint64_t root_offset = _header->root_offset;
+		if(root_offset < _header->data_offset + sizeof(ppool_record_st) || _header->bump_offset <= root_offset || PPOOL_RECORD_LIVE != _get_record(_base_ptr + root_offset)->state) {
+			_header->root_offset = 0;
+		}
+	}
+}
+
+ppool_record_st* persist_pool_c::_carve_record(std::uint64_t block_size)
+{
+	// caller must hold _ppool_lock.
+	if(auto iter = _free_head.find(block_size); _free_head.end() != iter && 0 != iter->second)
+	{
+		ppool_record_st* record = reinterpret_cast<ppool_record_st*>(_base_ptr + iter->second);
+		iter->second            = *reinterpret_cast<std::uint64_t*>(_get_object(record));
+
+		_free_cnt--;
+		return record;
+	}
+
+	if(_file_byte - _header->bump_offset < block_size)
+	{
+		U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "persist pool is full. grp_name:{}/file_path:{}/used_byte:{}/block_size:{}", _grp_name, _file_path, _header->bump_offset, block_size);
+		return nullptr;
+	}
+
+	// record header is written before bump_offset moves over it.
+	ppool_record_st* record = reinterpret_cast<ppool_record_st*>(_base_ptr + _header->bump_offset);
+	record->state           = PPOOL_RECORD_FREE;
+	record->type_tag        = 0;
+	record->block_size      = block_size;
+
+	_header->bump_offset += block_size;
+	return record;
+}
+
+void persist_pool_c::_free_record(ppool_record_st* record)
+{
+	// caller must hold _ppool_lock.
+	record->state    = PPOOL_RECORD_FREE;
+	record->type_tag = 0;
+
+	std::uint64_t& head = _free_head[record->block_size];
+
+	*reinterpret_cast<std::uint64_t*>(_get_object(record)) = head;
+	head = static_cast<std::uint64_t>(reinterpret_cast<char*>(record) - _base_ptr);
+
+	_free_cnt++;
+}
+
+persist_pool_c::persist_pool_c(const std::string& grp_name, const std::string& file_path, std::uint64_t file_byte)
+	: _grp_name(grp_name), _file_path(file_path)
+{
+	if(false == _open(file_byte) && -1 != _fd)
+	{
+		close(_fd);
+		_fd = -1;
+	}
+}
+
+persist_pool_c::~persist_pool_c()
+{
+	if(nullptr != _base_ptr)
+	{
+		_header->is_clean = 1;
+		if(-1 == msync(_base_ptr, _file_byte, MS_SYNC)) {
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "msync failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		}
+
+		if(-1 == munmap(_base_ptr, _file_byte)) {
+			U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "munmap failed. grp_name:{}/file_path:{}/errno:{}/errstr:{}", _grp_name, _file_path, errno, strerror(errno));
+		}
+	}
+
+	if(-1 != _fd) {
+		close(_fd);
+	}
+}
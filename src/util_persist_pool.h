@@ -0,0 +1,294 @@
+#ifndef PERSIST_POOL_H
+#define PERSIST_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+/* ====================================================================== */
+/* ========================== DEFINE & ENUM ============================= */
+/* ====================================================================== */
+	// file layout: [file header page][record][record]... every record is [record header][object], and starts on PPOOL_ALIGN_BYTE.
+	const std::uint64_t PPOOL_MAGIC       = 0x4C4F4F5050544C55ULL; // "ULTPPOOL"
+	const std::uint32_t PPOOL_VERSION     = 1;
+	const std::uint32_t PPOOL_ALIGN_BYTE  = 16;
+	const std::uint32_t PPOOL_RECORD_LIVE = 0x4556494C; // "LIVE"
+	const std::uint32_t PPOOL_RECORD_FREE = 0x45455246; // "FREE"
+
+/* ====================================================================== */
+/* ========================== CLASS & STRUCT ============================ */
+/* ====================================================================== */
+	/* first bytes of the file. the free-lists are not stored, they are rebuilt from records on attach. */
+	struct ppool_file_header_st
+	{
+		std::uint64_t magic       = 0;
+		std::uint32_t version     = 0;
+		std::uint32_t is_clean    = 0; // 1 when the last process closed the pool. (0 means it was killed)
+		std::uint64_t file_byte   = 0;
+		std::uint64_t data_offset = 0; // first record.
+		std::uint64_t bump_offset = 0; // end of carved records.
+		std::uint64_t root_offset = 0; // entry object of user. (0 is none)
+	};
+
+	/* state is written last on alloc and first on release, so a killed process never leaves a half-built live object. */
+	struct ppool_record_st
+	{
+		std::uint32_t state      = 0;
+		std::uint32_t type_tag   = 0;
+		std::uint64_t block_size = 0; // record header is included.
+	};
+
+	static_assert(PPOOL_ALIGN_BYTE == sizeof(ppool_record_st), "record header must keep object alignment");
+
+	/* type of record is told by U::PERSIST_TAG. (0 if U doesn't declare it) */
+	template <typename U, typename = void>
+	struct ppool_type_tag_st
+	{
+		static constexpr std::uint32_t value = 0;
+	};
+
+	template <typename U>
+	struct ppool_type_tag_st<U, std::void_t<decltype(U::PERSIST_TAG)>>
+	{
+		static constexpr std::uint32_t value = U::PERSIST_TAG;
+	};
+
+	/* reference between persistent objects. an offset from the file beginning stays valid after the file is mapped at another address. */
+	template <typename T>
+	struct persist_ref_st
+	{
+		std::uint64_t offset = 0;
+
+		bool is_null() const { return 0 == offset; };
+	};
+
+	/*
+	 * pool on a file mapped with MAP_SHARED. objects survive the process, and a restarted process re-attaches the file and walks
+	 * its live objects by for_each() or get_root() instead of building them again. file size is fixed at creation. (no growth)
+	 * only trivially copyable types without pointers to other objects are allowed, use persist_ref_st for links.
+	 * writes of a killed process remain in page-cache, sync() is needed only against power loss.
+	 * the file is locked with flock(LOCK_EX), so a second pool on the same file fails to open. (in any process)
+	 */
+	class persist_pool_c
+	{
+	public:
+		/* <-- special member functions --> */
+		persist_pool_c(const std::string& grp_name, const std::string& file_path, std::uint64_t file_byte);
+		~persist_pool_c();
+
+		persist_pool_c(const persist_pool_c& rhs)            = delete;
+		persist_pool_c& operator=(const persist_pool_c& rhs) = delete;
+		persist_pool_c(persist_pool_c&& rhs)                 = delete;
+		persist_pool_c& operator=(persist_pool_c&& rhs)      = delete;
+
+		// return nullptr when the file is full.
+		template <typename U, typename... Args>
+		U* alloc(Args&&... args);
+
+		template <typename U>
+		void release(U* obj);
+
+		// visit live objects of U in file order, and return the visited count. (func is called without the lock, it may alloc/release)
+		template <typename U, typename Func>
+		std::uint64_t for_each(Func&& func);
+
+		template <typename U>
+		persist_ref_st<U> to_ref(const U* obj) const { return persist_ref_st<U>{nullptr == obj ? 0 : static_cast<std::uint64_t>(reinterpret_cast<const char*>(obj) - _base_ptr)}; };
+
+		template <typename U>
+		U* from_ref(persist_ref_st<U> ref) const { return true == ref.is_null() ? nullptr : reinterpret_cast<U*>(_base_ptr + ref.offset); };
+
+		template <typename U>
+		void set_root(U* obj);
+
+		template <typename U>
+		U* get_root() const;
+
+		bool sync();
+
+		bool is_open() const { return nullptr != _base_ptr; };
+		bool is_attached() const { return _is_attached; };   // existing file was re-attached.
+		bool is_clean_close() const { return _is_clean_close; }; // the previous process closed the pool normally.
+
+		std::uint64_t get_live_cnt() const { std::lock_guard pool_lock(_ppool_lock); return _live_cnt; };
+		std::uint64_t get_free_cnt() const { std::lock_guard pool_lock(_ppool_lock); return _free_cnt; };
+		std::uint64_t get_used_byte() const { std::lock_guard pool_lock(_ppool_lock); return nullptr == _header ? 0 : _header->bump_offset; };
+		std::uint64_t get_file_byte() const { return _file_byte; };
+
+	private:
+		static constexpr std::uint64_t _get_block_size(std::size_t obj_size) { return sizeof(ppool_record_st) + (obj_size + PPOOL_ALIGN_BYTE - 1) / PPOOL_ALIGN_BYTE * PPOOL_ALIGN_BYTE; }
+
+		template <typename U>
+		static constexpr void _check_type();
+
+		bool _open(std::uint64_t file_byte);
+		bool _format();
+		bool _attach();
+		void _rebuild();
+
+		// caller must hold _ppool_lock.
+		ppool_record_st* _carve_record(std::uint64_t block_size);
+		void _free_record(ppool_record_st* record);
+
+		ppool_record_st* _get_record(const void* obj) const { return reinterpret_cast<ppool_record_st*>(const_cast<char*>(reinterpret_cast<const char*>(obj)) - sizeof(ppool_record_st)); };
+		void* _get_object(ppool_record_st* record) const { return reinterpret_cast<char*>(record) + sizeof(ppool_record_st); };
+
+		std::string           _grp_name;
+		std::string           _file_path;
+		int                   _fd             = -1;
+		char*                 _base_ptr       = nullptr;
+		ppool_file_header_st* _header         = nullptr;
+		std::uint64_t         _file_byte      = 0;
+		bool                  _is_attached    = false;
+		bool                  _is_clean_close = false;
+
+		std::unordered_map<std::uint64_t, std::uint64_t> _free_head; // block_size -> offset of the first free record. (link is in object area)
+		std::uint64_t _live_cnt = 0;
+		std::uint64_t _free_cnt = 0;
+
+		mutable std::mutex _ppool_lock;
+	};
+
+	template <typename U>
+	constexpr void persist_pool_c::_check_type()
+	{
+		static_assert(true == std::is_trivially_copyable_v<U>, "persistent object must be trivially copyable (relocatable)");
+		static_assert(false == std::is_polymorphic_v<U>, "persistent object must not have vtable");
+		static_assert(alignof(U) <= PPOOL_ALIGN_BYTE, "alignment of persistent object is too big");
+	}
+
+	template <typename U, typename... Args>
+	U* persist_pool_c::alloc(Args&&... args)
+	{
+		_check_type<U>();
+		if(nullptr == _base_ptr) {
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+
+		ppool_record_st* record = _carve_record(_get_block_size(sizeof(U)));
+		if(nullptr == record) {
+			return nullptr;
+		}
+
+		U* obj = ::new(_get_object(record)) U{std::forward<Args>(args)...};
+
+		record->type_tag = ppool_type_tag_st<U>::value;
+		record->state    = PPOOL_RECORD_LIVE;
+
+		_live_cnt++;
+		return obj;
+	}
+
+	template <typename U>
+	void persist_pool_c::release(U* obj)
+	{
+		_check_type<U>();
+		if(nullptr == obj) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+
+		ppool_record_st* record = _get_record(obj);
+		if(PPOOL_RECORD_LIVE != record->state) {
+			return;
+		}
+
+		if(_header->root_offset == static_cast<std::uint64_t>(reinterpret_cast<char*>(obj) - _base_ptr)) {
+			_header->root_offset = 0;
+		}
+
+		_free_record(record);
+		_live_cnt--;
+	}
+
+	template <typename U, typename Func>
+	std::uint64_t persist_pool_c::for_each(Func&& func)
+	{
+		_check_type<U>();
+		if(nullptr == _base_ptr) {
+			return 0;
+		}
+
+		auto is_live = [](const ppool_record_st* record) {
+			return PPOOL_RECORD_LIVE == record->state && ppool_type_tag_st<U>::value == record->type_tag && _get_block_size(sizeof(U)) == record->block_size;
+		};
+
+		std::vector<ppool_record_st*> vec_record;
+		{
+			std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+			for(std::uint64_t offset = _header->data_offset; offset < _header->bump_offset;)
+			{
+				ppool_record_st* record = reinterpret_cast<ppool_record_st*>(_base_ptr + offset);
+				if(true == is_live(record)) {
+					vec_record.push_back(record);
+				}
+
+				offset += record->block_size;
+			}
+		}
+
+		// an object released by an earlier call is skipped.
+		std::uint64_t visit_cnt = 0;
+		for(ppool_record_st* record : vec_record)
+		{
+			{
+				std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+				if(false == is_live(record)) {
+					continue;
+				}
+			}
+
+			func(*reinterpret_cast<U*>(_get_object(record)));
+			visit_cnt++;
+		}
+
+		return visit_cnt;
+	}
+
+	template <typename U>
+	void persist_pool_c::set_root(U* obj)
+	{
+		_check_type<U>();
+		if(nullptr == _base_ptr) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+		_header->root_offset = to_ref(obj).offset;
+	}
+
+	template <typename U>
+	U* persist_pool_c::get_root() const
+	{
+		_check_type<U>();
+		if(nullptr == _base_ptr) {
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> pool_lock(_ppool_lock);
+		if(0 == _header->root_offset) {
+			return nullptr;
+		}
+
+		// root must be a live object of U.
+		ppool_record_st* record = _get_record(_base_ptr + _header->root_offset);
+		if(PPOOL_RECORD_LIVE != record->state || ppool_type_tag_st<U>::value != record->type_tag || _get_block_size(sizeof(U)) != record->block_size) {
+			return nullptr;
+		}
+
+		return reinterpret_cast<U*>(_base_ptr + _header->root_offset);
+	}
+}
+
+#endif
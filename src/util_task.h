@@ -0,0 +1,145 @@
+#ifndef UTIL_TASK
+#define UTIL_TASK
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace util
+{
+    /* ====================================================================== */
+    /* ========================== DEFINE & ENUM ============================= */
+    /* ====================================================================== */
+    // task_c is one cache line. (inline storage + ops table)
+    const std::size_t TASK_INLINE_BYTE = 64 - sizeof(void*);
+
+    /* ====================================================================== */
+    /* ========================== CLASS & STRUCT ============================ */
+    /* ====================================================================== */
+    /*
+     * move-only void() callable for the thread pool queue. (replaces std::function<void()>)
+     * a callable up to TASK_INLINE_BYTE with nothrow move is stored inline, so a typical lambda needs no heap allocation.
+     * a bigger one is stored on heap and only its pointer moves. move-only captures (ex. std::unique_ptr) are allowed.
+     */
+    class task_c
+    {
+    public:
+        /* <-- special member functions --> */
+        task_c() = default;
+        ~task_c() { reset(); }
+
+        template <typename Func, typename = std::enable_if_t<false == std::is_same_v<std::decay_t<Func>, task_c>>>
+        task_c(Func&& func)
+        {
+            using func_type = std::decay_t<Func>;
+            if constexpr(true == _is_inline<func_type>()) {
+                ::new(static_cast<void*>(_storage)) func_type(std::forward<Func>(func));
+            }
+            else {
+                ::new(static_cast<void*>(_storage)) func_type*(new func_type(std::forward<Func>(func)));
+            }
+
+            _ops = &_ops_of<func_type>;
+        }
+
+        task_c(const task_c& rhs)            = delete;
+        task_c& operator=(const task_c& rhs) = delete;
+
+        task_c(task_c&& rhs) noexcept { _move_from(rhs); }
+
+        task_c& operator=(task_c&& rhs) noexcept
+        {
+            if(this != &rhs)
+            {
+                reset();
+                _move_from(rhs);
+            }
+
+            return *this;
+        }
+
+        void operator()() { _ops->invoke(_storage); }
+
+        void reset()
+        {
+            if(nullptr != _ops)
+            {
+                _ops->destroy(_storage);
+                _ops = nullptr;
+            }
+        }
+
+        bool is_inline() const { return nullptr != _ops && true == _ops->is_inline; }
+        explicit operator bool() const { return nullptr != _ops; }
+
+    private:
+        /* type-erased operations of the stored callable. (one static table per type) */
+        struct ops_st
+        {
+            void (*invoke)(void* storage);
+            void (*move)(void* dst, void* src); // src is destroyed.
+            void (*destroy)(void* storage);
+            bool is_inline;
+        };
+
+        template <typename Func>
+        static constexpr bool _is_inline() { return sizeof(Func) <= TASK_INLINE_BYTE && alignof(Func) <= alignof(std::max_align_t) && true == std::is_nothrow_move_constructible_v<Func>; }
+
+        template <typename Func>
+        static void _invoke(void* storage)
+        {
+            if constexpr(true == _is_inline<Func>()) {
+                (*std::launder(reinterpret_cast<Func*>(storage)))();
+            }
+            else {
+                (**std::launder(reinterpret_cast<Func**>(storage)))();
+            }
+        }
+
+        template <typename Func>
+        static void _move(void* dst, void* src)
+        {
+            if constexpr(true == _is_inline<Func>())
+            {
+                Func* src_func = std::launder(reinterpret_cast<Func*>(src));
+                ::new(dst) Func(std::move(*src_func));
+                src_func->~Func();
+            }
+            else {
+                ::new(dst) Func*(*std::launder(reinterpret_cast<Func**>(src)));
+            }
+        }
+
+        template <typename Func>
+        static void _destroy(void* storage)
+        {
+            if constexpr(true == _is_inline<Func>()) {
+                std::launder(reinterpret_cast<Func*>(storage))->~Func();
+            }
+            else {
+                delete *std::launder(reinterpret_cast<Func**>(storage));
+            }
+        }
+
+        template <typename Func>
+        static constexpr ops_st _ops_of{&_invoke<Func>, &_move<Func>, &_destroy<Func>, _is_inline<Func>()};
+
+        void _move_from(task_c& rhs) noexcept
+        {
+            if(nullptr != rhs._ops)
+            {
+                rhs._ops->move(_storage, rhs._storage);
+                _ops     = rhs._ops;
+                rhs._ops = nullptr;
+            }
+        }
+
+        alignas(std::max_align_t) unsigned char _storage[TASK_INLINE_BYTE];
+        const ops_st* _ops = nullptr;
+    };
+
+    static_assert(64 == sizeof(task_c), "task_c must be one cache line");
+} // namespace util
+
+#endif
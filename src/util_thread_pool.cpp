@@ -1,5 +1,6 @@
 #include "util_thread_pool.h"
 
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <limits>
@@ -19,6 +20,13 @@ const monitoring Green{1, 3};
 const monitoring Yellow{4, 6};
 const monitoring Red{7, 10};
 
+/* ====================================================================== */
+/* ========================== GLOBAL & STATIC =========================== */
+/* ====================================================================== */
+/* set only in consumer threads. a task dispatched from them goes to their own deque. */
+static thread_local thread_pool_c* t_owner_pool = nullptr;
+static thread_local std::uint16_t  t_worker_idx = 0;
+
 /* ====================================================================== */
 /* ========================== CLASS & STRUCT ============================ */
 /* ====================================================================== */
@@ -27,20 +35,25 @@ thread_pool_c::~thread_pool_c()
     _shutdown.exchange(true);
 
     // awake producer thread.
-    std::uint64_t value = 1;
-    static_assert(sizeof(value) == FD_EVENT_TYPE_SIZE, "[ERROR] value-size mismatch for write(event_fd). need_size: FD_EVENT_TYPE_SIZE");
+    if(true == _task_producer.joinable())
+    {
+        std::uint64_t value = 1;
+        static_assert(sizeof(value) == FD_EVENT_TYPE_SIZE, "[ERROR] value-size mismatch for write(event_fd). need_size: FD_EVENT_TYPE_SIZE");
 
-	ssize_t result = write(_event_fd, &value, sizeof(value));
-	if(FD_EVENT_TYPE_SIZE != result) {
-		U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "write() is weird. return_value: {}.", result);
-	}
+        ssize_t result = write(_event_fd, &value, sizeof(value));
+        if(FD_EVENT_TYPE_SIZE != result) {
+            U_LOG_ROTATE_FILE(util::LOG_LEVEL::CRITICAL, "write() is weird. return_value: {}.", result);
+        }
 
-    if(true == _task_producer.joinable()) {
         _task_producer.join();
     }
 
-    // awake consumer thread.
-    _task_cv.notify_all();
+    // awake consumer thread. (lock pairs with the predicate check of parked consumer)
+    {
+        std::lock_guard<std::mutex> lock_obj(_task_mutex);
+        while(-1 != _wake_parked());
+    }
+
     for(auto& task_consumer : _task_consumer_pool)
     {
         if(true == task_consumer.joinable()) {
@@ -48,20 +61,35 @@ thread_pool_c::~thread_pool_c()
         }
     }
 
+    // task pushed while consumers were leaving runs here, so no future is left pending.
+    if(false == _worker_queue.empty())
+    {
+        task_c task;
+        while(true == _pop_task(0, task))
+        {
+            task();
+            task.reset();
+        }
+    }
+
     close(_event_fd);
     _task_consumer_pool.clear();
 }
 
-bool thread_pool_c::create_pool(const std::string& identification, std::uint16_t max_cnt)
+bool thread_pool_c::create_pool(const std::string& identification, std::uint16_t max_cnt, TPOOL_DISPATCH dispatch_mode)
 {
     _shutdown       = false;
-    _ready_task     = false;
     _identification = identification;
     _max_cnt        = max_cnt;
+    _dispatch_mode  = dispatch_mode;
 
     // create event_fd with semaphore option.
     _event_fd = eventfd(0, EFD_SEMAPHORE);
-    _consumer_elapsed_time.resize(max_cnt, 0);
+    _consumer_elapsed_time = std::vector<std::atomic<std::int64_t>>(max_cnt);
+
+    for(std::uint16_t idx = 0; idx < max_cnt; idx++) {
+        _worker_queue.push_back(std::make_unique<worker_queue_st>());
+    }
 
     // checking all consumer thread is ready.
     std::vector<std::future<void>> check_consumer_ready;
@@ -73,7 +101,10 @@ bool thread_pool_c::create_pool(const std::string& identification, std::uint16_t
         _task_consumer_pool.push_back(std::thread(&thread_pool_c::_task_consumer_thread, this, std::move(ready_signal), idx));
     }
 
-    _task_producer = std::thread(&thread_pool_c::_task_producer_thread, this);
+    // direct dispatch has no producer hop.
+    if(TPOOL_DISPATCH::PRODUCER == _dispatch_mode) {
+        _task_producer = std::thread(&thread_pool_c::_task_producer_thread, this);
+    }
     for(auto& consumer_future : check_consumer_ready)
     {
         if(std::future_status::ready == consumer_future.wait_for(std::chrono::milliseconds(500))) {
@@ -86,7 +117,7 @@ bool thread_pool_c::create_pool(const std::string& identification, std::uint16_t
         }
     }
 
-    U_LOG_ROTATE_FILE(util::LOG_LEVEL::DEBUG, "[{}] all consumer thread is ready. count:{}", _identification, _max_cnt);
+    U_LOG_ROTATE_FILE(util::LOG_LEVEL::DEBUG, "[{}] all consumer thread is ready. count:{}/dispatch_mode:{}", _identification, _max_cnt, static_cast<std::uint16_t>(_dispatch_mode));
     return true;
 }
 
@@ -95,6 +126,9 @@ void thread_pool_c::_task_consumer_thread(std::promise<void> ready_signal, std::
     std::uint16_t idx = index;
     auto          _id = std::this_thread::get_id();
 
+    t_owner_pool = this;
+    t_worker_idx = idx;
+
     {
         std::lock_guard<std::mutex> _guard(_mgr_mutex);
         _consumer_mgr.insert(std::make_pair(_id, true));
@@ -103,55 +137,254 @@ void thread_pool_c::_task_consumer_thread(std::promise<void> ready_signal, std::
     ready_signal.set_value();
 
     // proceed task
-    std::function<void()> task;
+    task_c task;
     while(true)
     {
+        if(false == _pop_task(idx, task))
         {
-            std::unique_lock<std::mutex> lock_obj(_task_mutex);
-
-            _consumer_mgr[_id].exchange(true);
-            _task_cv.wait(lock_obj, [&]() {
-                	bool shutdown   = _shutdown.load();
-                	bool ready_task = _ready_task.load();
-
-                	return shutdown | ready_task;
-            	});
-
-            // thread shutdown.
+            // thread shutdown. (queued tasks are drained first, so every future is completed)
             if(bool shutdown = _shutdown.load(); true == shutdown)
             {
                 U_LOG_ROTATE_FILE(util::LOG_LEVEL::DEBUG, "[{}] consumer thread_id({}) is shutdown.", _identification, _id);
                 break;
             }
 
-            // handle task.
-            if(bool ready_task = _ready_task.load(); false == ready_task)
-            {
-                U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "[{}] consumer thread_id({}) is wake up, but ready_task is false.", _identification, _id);
-                continue;
-            }
+            worker_queue_st&             worker_queue = *_worker_queue[idx];
+            std::unique_lock<std::mutex> lock_obj(_task_mutex);
 
-            _ready_task.exchange(false);
-            if(true == _task_queue.empty()) // this code never execute. (maybe)
+            // submitter increases pending count before it looks for a parked consumer.
+            _idle_cnt.fetch_add(1);
+            if(0 < _pending_cnt.load() || true == _shutdown.load())
             {
-                U_LOG_ROTATE_FILE(util::LOG_LEVEL::WARNING, "[{}] consumer thread_id({}) is wake up, but task_queue is empty.", _identification, _id);
+                _idle_cnt.fetch_sub(1);
                 continue;
             }
 
-            task = _task_queue.front();
-            _task_queue.pop();
+            _consumer_mgr[_id].exchange(true);
+            _parked_stack.push_back(idx);
+            worker_queue.park_cv.wait(lock_obj, [&]() {
+                	bool shutdown = _shutdown.load();
+                	return shutdown | worker_queue.is_woken;
+            	});
 
+            worker_queue.is_woken = false;
+            _idle_cnt.fetch_sub(1);
             _consumer_mgr[_id].exchange(false);
+            continue;
         }
 
         auto begin_time = std::chrono::system_clock::now();
         task();
         auto end_time = std::chrono::system_clock::now();
 
+        // captured objects are released before waiting.
+        task.reset();
+
         // calc elpased time for the task.
         auto elapsed_time           = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - begin_time);
-        _consumer_elapsed_time[idx] = elapsed_time.count();
+        _consumer_elapsed_time[idx].store(elapsed_time.count(), std::memory_order_relaxed);
+    }
+
+    t_owner_pool = nullptr;
+}
+
+void thread_pool_c::_push_task(task_c&& task)
+{
+    // dispatched inside a consumer of this pool. (no _task_mutex and no producer hop)
+    if(this == t_owner_pool)
+    {
+        worker_queue_st& worker_queue = *_worker_queue[t_worker_idx];
+        {
+            std::lock_guard<std::mutex> lock_obj(worker_queue.lock);
+            worker_queue.deque.push_back(std::move(task));
+        }
+
+        // idle consumer is woken up to steal it. (it sees the pending count before parking, or it is parked already)
+        _pending_cnt.fetch_add(1);
+        if(0 < _idle_cnt.load())
+        {
+            std::lock_guard<std::mutex> lock_obj(_task_mutex);
+            _wake_parked();
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock_obj(_task_mutex);
+        _task_queue.push(std::move(task));
+
+        _shared_cnt.fetch_add(1);
+        _pending_cnt.fetch_add(1);
+
+        if(TPOOL_DISPATCH::DIRECT == _dispatch_mode)
+        {
+            _wake_parked();
+            return;
+        }
+    }
+
+    _signal_producer();
+}
+
+void thread_pool_c::_push_bulk(std::vector<task_c>& vec_task)
+{
+    if(true == vec_task.empty()) {
+        return;
+    }
+
+    std::uint64_t task_cnt = vec_task.size();
+    if(this == t_owner_pool)
+    {
+        worker_queue_st& worker_queue = *_worker_queue[t_worker_idx];
+        {
+            std::lock_guard<std::mutex> lock_obj(worker_queue.lock);
+            for(auto& task : vec_task) {
+                worker_queue.deque.push_back(std::move(task));
+            }
+        }
+
+        // idle consumers are woken up to steal them. (same as _push_task)
+        _pending_cnt.fetch_add(static_cast<std::int64_t>(task_cnt));
+        if(0 < _idle_cnt.load())
+        {
+            std::lock_guard<std::mutex> lock_obj(_task_mutex);
+            _wake_parked(task_cnt);
+        }
+
+        return;
     }
+
+    {
+        std::lock_guard<std::mutex> lock_obj(_task_mutex);
+        for(auto& task : vec_task) {
+            _task_queue.push(std::move(task));
+        }
+
+        _shared_cnt.fetch_add(static_cast<std::int64_t>(task_cnt));
+        _pending_cnt.fetch_add(static_cast<std::int64_t>(task_cnt));
+
+        if(TPOOL_DISPATCH::DIRECT == _dispatch_mode)
+        {
+            _wake_parked(task_cnt);
+            return;
+        }
+    }
+
+    // one signal for the whole batch, the producer wakes consumers for every queued task at once.
+    _signal_producer();
+}
+
+void thread_pool_c::_signal_producer()
+{
+    // awake producer thread with event_fd. (semaphore counter, it reads 1 per signal)
+    std::uint64_t value = 1;
+    static_assert(sizeof(value) == FD_EVENT_TYPE_SIZE, "[ERROR] value-size mismatch for write(event_fd). need_size: FD_EVENT_TYPE_SIZE");
+
+    ssize_t result = write(_event_fd, &value, sizeof(value));
+    if(FD_EVENT_TYPE_SIZE != result) {
+        U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "write() is weird. return_value: {}.", result);
+    }
+}
+
+std::int32_t thread_pool_c::_wake_parked()
+{
+    if(true == _parked_stack.empty()) {
+        return -1;
+    }
+
+    std::uint16_t idx = _parked_stack.back();
+    _parked_stack.pop_back();
+
+    // notified under _task_mutex, the consumer can't miss it.
+    worker_queue_st& worker_queue = *_worker_queue[idx];
+    worker_queue.is_woken         = true;
+    worker_queue.park_cv.notify_one();
+
+    return idx;
+}
+
+std::uint64_t thread_pool_c::_wake_parked(std::uint64_t task_cnt)
+{
+    // no more than the parked consumers, a busy one takes the rest after its task.
+    std::uint64_t woken_cnt = 0;
+    while(woken_cnt < task_cnt && -1 != _wake_parked()) {
+        woken_cnt++;
+    }
+
+    return woken_cnt;
+}
+
+bool thread_pool_c::_pop_task(std::uint16_t index, task_c& task)
+{
+    // 1. own deque. (newest task, its data is still hot in cache)
+    {
+        worker_queue_st& worker_queue = *_worker_queue[index];
+
+        std::lock_guard<std::mutex> lock_obj(worker_queue.lock);
+        if(false == worker_queue.deque.empty())
+        {
+            task = std::move(worker_queue.deque.back());
+            worker_queue.deque.pop_back();
+
+            _pending_cnt.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 2. shared queue of external tasks.
+    if(0 < _shared_cnt.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock_obj(_task_mutex);
+        if(false == _task_queue.empty())
+        {
+            task = std::move(_task_queue.front());
+            _task_queue.pop();
+
+            _shared_cnt.fetch_sub(1);
+            _pending_cnt.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 3. oldest task of a peer.
+    return _steal_task(index, task);
+}
+
+bool thread_pool_c::_steal_task(std::uint16_t index, task_c& task)
+{
+    // busy deque is skipped at first, and locked only when every deque was skipped or empty while tasks are pending.
+    for(bool is_blocking : {false, true})
+    {
+        if(true == is_blocking && _pending_cnt.load() <= _shared_cnt.load()) {
+            break;
+        }
+
+        for(std::uint16_t offset = 1; offset < _max_cnt; offset++)
+        {
+            worker_queue_st& worker_queue = *_worker_queue[(index + offset) % _max_cnt];
+
+            std::unique_lock<std::mutex> lock_obj(worker_queue.lock, std::defer_lock);
+            if(true == is_blocking) {
+                lock_obj.lock();
+            }
+            else if(false == lock_obj.try_lock()) {
+                continue;
+            }
+
+            if(false == worker_queue.deque.empty())
+            {
+                task = std::move(worker_queue.deque.front());
+                worker_queue.deque.pop_front();
+
+                _pending_cnt.fetch_sub(1);
+                _steal_cnt.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
 void thread_pool_c::_task_producer_thread()
@@ -182,8 +415,10 @@ void thread_pool_c::_task_producer_thread()
         while(true)
         {
             std::int64_t total_elapse_time = 0;
-            for(auto& elapse_time : _consumer_elapsed_time)
+            for(auto& consumer_elapsed_time : _consumer_elapsed_time)
             {
+                std::int64_t elapse_time = consumer_elapsed_time.load(std::memory_order_relaxed);
+
                 if(elapse_time < wait_min_time_ms) {
                     wait_min_time_ms = elapse_time;
                 }
@@ -198,10 +433,11 @@ void thread_pool_c::_task_producer_thread()
             wait_mean_time_ms = total_elapse_time / static_cast<std::int64_t>(_consumer_elapsed_time.size());
 
             // try to awake consumer thread.
+            // a bulk push is signaled once, so as many consumers as the queued tasks are woken. (no more than the parked ones)
             if(true == _check_exec_right_now())
             {
-                _ready_task.exchange(true);
-                _task_cv.notify_one();
+                std::lock_guard<std::mutex> lock_obj(_task_mutex);
+                _wake_parked(static_cast<std::uint64_t>(std::max<std::int64_t>(_shared_cnt.load(), 1)));
                 break;
             }
 
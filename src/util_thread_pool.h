@@ -2,16 +2,28 @@
 #define UTIL_THREAD_POOL
 
 #include "util_logger.h"
+#include "util_task.h"
 
 #include <atomic>
 #include <cstdint>
 #include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iterator>
 #include <future>
 #include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <unistd.h>
 
 #include <sys/eventfd.h>
@@ -24,44 +36,171 @@ namespace util
     using EVENT_FD                         = std::int32_t;
     const std::uint16_t FD_EVENT_TYPE_SIZE = 8;
 
+    enum class TPOOL_DISPATCH : std::uint16_t
+    {
+        PRODUCER = 1, // submitter -> event_fd -> producer thread -> consumer. (producer paces wake-up by elapsed time of consumers)
+        DIRECT        // submitter wakes a parked consumer by itself. (no producer thread)
+    };
+
     /* ====================================================================== */
     /* ========================== CLASS & STRUCT ============================ */
     /* ====================================================================== */
+    class thread_pool_c;
+
+    template <typename T>
+    class task_future_c;
+
+    /* value of a void task. */
+    struct task_void_st {};
+
+    /* result slot shared by a submitted task and its task_future_c. (one allocation per submit) */
+    template <typename T>
+    struct task_state_st
+    {
+        using value_type = std::conditional_t<true == std::is_void_v<T>, task_void_st, T>;
+
+        template <typename Task>
+        void run(Task& task);
+
+        // continuation is dispatched to the pool after the lock is released.
+        void complete(std::optional<value_type>&& result, std::exception_ptr result_error);
+
+        std::mutex              lock;
+        std::condition_variable ready_cv;
+        bool                    is_ready = false;
+
+        std::optional<value_type> value;
+        std::exception_ptr        error;
+        task_c                    continuation;
+        thread_pool_c*            pool = nullptr;
+    };
+
+    /* task of thread_pool_c::submit(). the state is broken when the task is destroyed without running. (std::future_errc::broken_promise) */
+    template <typename T, typename Func, typename ArgTuple>
+    struct submit_task_st
+    {
+        submit_task_st(std::shared_ptr<task_state_st<T>> state, Func&& func, ArgTuple&& arg_tuple)
+            : state(std::move(state)), func(std::move(func)), arg_tuple(std::move(arg_tuple)) {}
+
+        ~submit_task_st();
+
+        submit_task_st(submit_task_st&& rhs)                 = default;
+        submit_task_st& operator=(submit_task_st&& rhs)      = delete;
+        submit_task_st(const submit_task_st& rhs)            = delete;
+        submit_task_st& operator=(const submit_task_st& rhs) = delete;
+
+        void operator()();
+
+        std::shared_ptr<task_state_st<T>> state; // nullptr after the task ran or was moved.
+        Func                              func;
+        ArgTuple                          arg_tuple;
+    };
+
+    /*
+     * future of thread_pool_c::submit(). get() blocks and rethrows an exception of the task.
+     * then() registers a continuation which runs on the pool when the result is ready, so no thread blocks on get().
+     * get() and then() consume the future. (valid() is false after them) the pool must outlive a pending continuation.
+     */
+    template <typename T>
+    class task_future_c
+    {
+    public:
+        /* <-- special member functions --> */
+        task_future_c() = default;
+        explicit task_future_c(std::shared_ptr<task_state_st<T>> state) : _state(std::move(state)) {}
+        ~task_future_c() = default;
+
+        task_future_c(const task_future_c& rhs)            = delete;
+        task_future_c& operator=(const task_future_c& rhs) = delete;
+        task_future_c(task_future_c&& rhs)                 = default;
+        task_future_c& operator=(task_future_c&& rhs)      = default;
+
+        T get();
+        void wait() const;
+
+        // func takes the value. (nothing for void) an exception of this task skips func, and is passed to the returned future.
+        template <typename Func>
+        auto then(Func&& func);
+
+        bool valid() const { return nullptr != _state; }
+        bool is_ready() const;
+
+    private:
+        std::shared_ptr<task_state_st<T>> _state;
+    };
+
+    /*
+     * every consumer owns a deque. (work-stealing)
+     * a task dispatched inside a consumer is pushed to its own deque without _task_mutex, and the owner pops it in LIFO order.
+     * a task from outside goes to the shared _task_queue through the producer thread as before.
+     * a consumer whose deque is empty takes the shared queue, and then steals the oldest task of a peer.
+     * a consumer without any task parks itself on _parked_stack, and is woken up alone by its own condition variable.
+     * in TPOOL_DISPATCH::DIRECT, the submitter pops the parked stack instead of the producer thread. (latest parked one is cache-warm)
+     * on destruction, tasks already queued still run before the consumers leave, so every future is completed.
+     */
     class thread_pool_c
     {
     public:
-        bool create_pool(const std::string& identification, std::uint16_t max_cnt);
+        bool create_pool(const std::string& identification, std::uint16_t max_cnt, TPOOL_DISPATCH dispatch_mode = TPOOL_DISPATCH::PRODUCER);
 
         template <typename Func, typename... Args>
         bool async_dispatch(Func&& func, Args&&... args)
         {
-            // when shutdown flag is true, no more tasks should be enqueued.
+            // when shutdown flag is true, no more tasks should be enqueued. (func is untouched)
             if(bool shutdown = _shutdown.load(); true == shutdown)
             {
                 U_LOG_ROTATE_FILE(util::LOG_LEVEL::DEBUG, "[{}] thread_pool is shutdown.", _identification);
                 return false;
             }
 
-            // make task with function and variable.
-            auto task = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+            // func and args are moved into the task, and the task is only moved until it runs. (args are passed as lvalues like std::bind)
+            if constexpr(0 == sizeof...(Args)) {
+                _push_task(task_c(std::forward<Func>(func)));
+            }
+            else
+            {
+                _push_task(task_c([func = std::forward<Func>(func), arg_tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                    std::apply(func, arg_tuple);
+                }));
+            }
+
+            return true;
+        }
 
+        // every element is a callable, and is moved into the pool. (one lock and one wake-up signal for the whole batch)
+        template <typename Iter>
+        bool dispatch_bulk(Iter first, Iter last)
+        {
+            if(bool shutdown = _shutdown.load(); true == shutdown)
             {
-                std::lock_guard<std::mutex> lock_obj(_task_mutex);
-                _task_queue.push(task);
+                U_LOG_ROTATE_FILE(util::LOG_LEVEL::DEBUG, "[{}] thread_pool is shutdown.", _identification);
+                return false;
             }
 
-            // awake producer thread with event_fd.
-            std::uint64_t value = 1;
-            static_assert(sizeof(value) == FD_EVENT_TYPE_SIZE, "[ERROR] value-size mismatch for write(event_fd). need_size: FD_EVENT_TYPE_SIZE");
+            std::vector<task_c> vec_task;
+            if constexpr(true == std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<Iter>::iterator_category>) {
+                vec_task.reserve(static_cast<std::size_t>(std::distance(first, last)));
+            }
 
-            ssize_t result = write(_event_fd, &value, sizeof(value));
-			if(FD_EVENT_TYPE_SIZE != result) {
-				U_LOG_ROTATE_FILE(util::LOG_LEVEL::ERROR, "write() is weird. return_value: {}.", result);
-			}
+            for(; first != last; ++first) {
+                vec_task.emplace_back(std::move(*first));
+            }
 
+            _push_bulk(vec_task);
             return true;
         }
 
+        template <typename Range>
+        bool dispatch_bulk(Range&& range) { return dispatch_bulk(std::begin(range), std::end(range)); }
+
+        // result and exception of func are delivered by the future. (broken with std::runtime_error after shutdown)
+        // func returning a reference gives the future of a copy.
+        template <typename Func, typename... Args>
+        auto submit(Func&& func, Args&&... args);
+
+        std::uint64_t get_steal_cnt() const { return _steal_cnt.load(std::memory_order_relaxed); }
+        TPOOL_DISPATCH get_dispatch_mode() const { return _dispatch_mode; }
+
         /* <-- special member functions --> */
         thread_pool_c() = default;
         ~thread_pool_c();
@@ -72,28 +211,237 @@ namespace util
         thread_pool_c& operator=(thread_pool_c&& rhs)      = delete;
 
     private:
+        /* deque of each consumer. owner uses the back, thieves take the front. */
+        struct worker_queue_st
+        {
+            std::mutex                        lock;
+            std::deque<task_c>                deque;
+
+            std::condition_variable park_cv;
+            bool                    is_woken = false; // guarded by _task_mutex.
+        };
+
         void _task_consumer_thread(std::promise<void> ready_signal, std::uint16_t index);
         void _task_producer_thread();
         bool _check_exec_right_now();
 
+        void _push_task(task_c&& task);
+        void _push_bulk(std::vector<task_c>& vec_task);
+        void _signal_producer();
+        bool _pop_task(std::uint16_t index, task_c& task);
+        bool _steal_task(std::uint16_t index, task_c& task);
+
+        // caller must hold _task_mutex. return the index of the woken consumer, or -1 when nobody is parked.
+        std::int32_t _wake_parked();
+        std::uint64_t _wake_parked(std::uint64_t task_cnt);
+
     private:
         std::atomic_bool _shutdown;
-        std::atomic_bool _ready_task;
         std::uint16_t    _max_cnt;
+        TPOOL_DISPATCH   _dispatch_mode = TPOOL_DISPATCH::PRODUCER;
         EVENT_FD         _event_fd;
 
+        std::atomic<std::int64_t>  _pending_cnt{0}; // tasks in every queue.
+        std::atomic<std::int64_t>  _shared_cnt{0};  // tasks in _task_queue.
+        std::atomic<std::int32_t>  _idle_cnt{0};    // consumers on _parked_stack or just woken.
+        std::atomic<std::uint64_t> _steal_cnt{0};
+
+        std::vector<std::unique_ptr<worker_queue_st>> _worker_queue;
+        std::vector<std::uint16_t>                    _parked_stack; // guarded by _task_mutex.
+
         std::string                                 _identification;
-        std::vector<std::int64_t>                   _consumer_elapsed_time;
+        std::vector<std::atomic<std::int64_t>>      _consumer_elapsed_time; // written by each consumer, read by producer.
         std::vector<std::thread>                    _task_consumer_pool;
-        std::queue<std::function<void()>>           _task_queue;
+        std::queue<task_c>                          _task_queue;
         std::map<std::thread::id, std::atomic_bool> _consumer_mgr;
 
         std::mutex  _task_mutex;
         std::mutex  _mgr_mutex;
         std::thread _task_producer;
-
-        std::condition_variable _task_cv;
     };
+
+    template <typename T>
+    template <typename Task>
+    void task_state_st<T>::run(Task& task)
+    {
+        std::optional<value_type> result;
+        std::exception_ptr        result_error;
+
+        try
+        {
+            if constexpr(true == std::is_void_v<T>)
+            {
+                task();
+                result.emplace();
+            }
+            else {
+                result.emplace(task());
+            }
+        }
+        catch(...) {
+            result_error = std::current_exception();
+        }
+
+        complete(std::move(result), result_error);
+    }
+
+    template <typename T>
+    void task_state_st<T>::complete(std::optional<value_type>&& result, std::exception_ptr result_error)
+    {
+        task_c next_task;
+        {
+            std::lock_guard<std::mutex> lock_obj(lock);
+
+            value    = std::move(result);
+            error    = result_error;
+            is_ready = true;
+
+            next_task = std::move(continuation);
+        }
+
+        ready_cv.notify_all();
+
+        // runs here when the pool doesn't accept it any more.
+        if(true == static_cast<bool>(next_task) && (nullptr == pool || false == pool->async_dispatch(std::move(next_task)))) {
+            next_task();
+        }
+    }
+
+    template <typename T, typename Func, typename ArgTuple>
+    submit_task_st<T, Func, ArgTuple>::~submit_task_st()
+    {
+        if(nullptr != state) {
+            state->complete(std::nullopt, std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    template <typename T, typename Func, typename ArgTuple>
+    void submit_task_st<T, Func, ArgTuple>::operator()()
+    {
+        std::shared_ptr<task_state_st<T>> run_state = std::move(state);
+
+        auto task = [this]() -> decltype(auto) { return std::apply(func, arg_tuple); };
+        run_state->run(task);
+    }
+
+    template <typename T>
+    T task_future_c<T>::get()
+    {
+        if(nullptr == _state) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+
+        std::shared_ptr<task_state_st<T>> state = std::move(_state);
+        {
+            std::unique_lock<std::mutex> lock_obj(state->lock);
+            state->ready_cv.wait(lock_obj, [&state]() { return state->is_ready; });
+        }
+
+        if(nullptr != state->error) {
+            std::rethrow_exception(state->error);
+        }
+
+        if constexpr(false == std::is_void_v<T>) {
+            return std::move(*state->value);
+        }
+    }
+
+    template <typename T>
+    void task_future_c<T>::wait() const
+    {
+        if(nullptr == _state) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock_obj(_state->lock);
+        _state->ready_cv.wait(lock_obj, [this]() { return _state->is_ready; });
+    }
+
+    template <typename T>
+    bool task_future_c<T>::is_ready() const
+    {
+        if(nullptr == _state) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock_obj(_state->lock);
+        return _state->is_ready;
+    }
+
+    template <typename T>
+    template <typename Func>
+    auto task_future_c<T>::then(Func&& func)
+    {
+        using arg_type    = typename task_state_st<T>::value_type;
+        using result_type = std::conditional_t<true == std::is_void_v<T>, std::invoke_result<std::decay_t<Func>&>, std::invoke_result<std::decay_t<Func>&, arg_type&&>>;
+        using next_type   = std::remove_cv_t<std::remove_reference_t<typename result_type::type>>;
+
+        if(nullptr == _state) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+
+        std::shared_ptr<task_state_st<T>> state = std::move(_state);
+
+        auto next_state  = std::make_shared<task_state_st<next_type>>();
+        next_state->pool = state->pool;
+
+        task_c continuation = [state, next_state, next_func = std::decay_t<Func>(std::forward<Func>(func))]() mutable {
+            if(nullptr != state->error)
+            {
+                next_state->complete(std::nullopt, state->error);
+                return;
+            }
+
+            auto task = [&]() -> next_type {
+                if constexpr(true == std::is_void_v<T>) {
+                    return next_func();
+                }
+                else {
+                    return next_func(std::move(*state->value));
+                }
+            };
+
+            next_state->run(task);
+        };
+
+        {
+            std::unique_lock<std::mutex> lock_obj(state->lock);
+            if(false == state->is_ready)
+            {
+                state->continuation = std::move(continuation);
+                return task_future_c<next_type>(std::move(next_state));
+            }
+        }
+
+        // already done, dispatched right now.
+        if(nullptr == state->pool || false == state->pool->async_dispatch(std::move(continuation))) {
+            continuation();
+        }
+
+        return task_future_c<next_type>(std::move(next_state));
+    }
+
+    template <typename Func, typename... Args>
+    auto thread_pool_c::submit(Func&& func, Args&&... args)
+    {
+        // reference result is copied into the state, so the future never refers to an object of the task.
+        using result_type = std::remove_cv_t<std::remove_reference_t<std::invoke_result_t<std::decay_t<Func>&, std::decay_t<Args>&...>>>;
+
+        auto state  = std::make_shared<task_state_st<result_type>>();
+        state->pool = this;
+
+        auto arg_tuple = std::make_tuple(std::forward<Args>(args)...);
+        submit_task_st<result_type, std::decay_t<Func>, decltype(arg_tuple)> task(state, std::decay_t<Func>(std::forward<Func>(func)), std::move(arg_tuple));
+
+        // rejected task is untouched, so it is broken here with the reason instead of broken_promise.
+        if(false == async_dispatch(std::move(task)))
+        {
+            task.state.reset();
+            state->complete(std::nullopt, std::make_exception_ptr(std::runtime_error("thread_pool is shutdown")));
+        }
+
+        return task_future_c<result_type>(std::move(state));
+    }
 } // namespace util
 
 #endif